@@ -895,8 +895,24 @@ SerialArena* ThreadSafeArena::GetSerialArenaFallback(size_t n) {
   return serial;
 }
 
+HeapAllocator heap_allocator;
+std::atomic<bool> heap_used_default_allocator{false};
+
 }  // namespace internal
 
+void SetHeapAllocator(const HeapAllocator& allocator) {
+  ABSL_CHECK(allocator.allocate != nullptr && allocator.deallocate != nullptr)
+      << "HeapAllocator needs both allocate and deallocate.";
+  ABSL_CHECK(internal::heap_allocator.allocate == nullptr)
+      << "SetHeapAllocator() may only be called once.";
+  // Memory that is already out would be handed to the new deallocator.
+  ABSL_CHECK(!internal::heap_used_default_allocator.load(
+      std::memory_order_relaxed))
+      << "SetHeapAllocator() must be called before any message allocates "
+         "memory.";
+  internal::heap_allocator = allocator;
+}
+
 void* Arena::Allocate(size_t n) { return impl_.AllocateAligned(n); }
 
 void* Arena::AllocateForArray(size_t n) {
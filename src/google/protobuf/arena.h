@@ -33,7 +33,9 @@
 #ifndef GOOGLE_PROTOBUF_ARENA_H__
 #define GOOGLE_PROTOBUF_ARENA_H__
 
+#include <atomic>
 #include <limits>
+#include <new>
 #include <type_traits>
 #include <utility>
 #if defined(_MSC_VER) && !defined(_LIBCPP_STD_VER) && !_HAS_EXCEPTIONS
@@ -157,6 +159,99 @@ struct ArenaOptions {
   friend class ArenaOptionsTestFriend;
 };
 
+// Functions used to allocate and free the memory owned by messages that are
+// not on an arena: the messages themselves, and the storage of their repeated
+// fields and maps. By default the global operator new and delete are used.
+//
+// This lets programs that cannot use arenas route that memory to size-class
+// pools or to a dedicated malloc arena, or account for it. The allocator is
+// process wide and is installed once, with SetHeapAllocator(), before the
+// first message is created: memory is always handed back to the allocator
+// installed at that time. An allocator that behaves differently per thread
+// must still be able to free memory allocated on any other thread.
+//
+// Strings and over-aligned message types still use the global allocator.
+struct HeapAllocator {
+  // Returns at least `size` bytes, aligned like the global operator new.
+  // `new (std::nothrow)` calls it too, and passes a nullptr result on.
+  void* (*allocate)(size_t size) = nullptr;
+  // Frees memory returned by `allocate`. `size` is the size that was asked
+  // for, or 0 when a constructor throws after `new (std::nothrow)`.
+  void (*deallocate)(void* p, size_t size) = nullptr;
+};
+
+// Installs `allocator` for all heap allocations described above. It must set
+// both functions, and may be called at most once per process, before any
+// message, repeated field or map has allocated memory; both are checked.
+// Not thread-safe.
+PROTOBUF_EXPORT void SetHeapAllocator(const HeapAllocator& allocator);
+
+namespace internal {
+
+// The allocator installed with SetHeapAllocator(). Do not use directly.
+PROTOBUF_EXPORT extern HeapAllocator heap_allocator;
+
+// Set once the global allocator has handed out memory that will be freed with
+// DeallocateHeap(); SetHeapAllocator() refuses to run after that.
+PROTOBUF_EXPORT extern std::atomic<bool> heap_used_default_allocator;
+
+inline void NoteDefaultHeapAllocation() {
+  // Only store when needed, so that the cache line is not written on every
+  // allocation.
+  if (PROTOBUF_PREDICT_FALSE(
+          !heap_used_default_allocator.load(std::memory_order_relaxed))) {
+    heap_used_default_allocator.store(true, std::memory_order_relaxed);
+  }
+}
+
+// Allocates memory owned by a message that is not on an arena. It must be
+// released with DeallocateHeap().
+inline void* AllocateHeap(size_t size) {
+  if (PROTOBUF_PREDICT_FALSE(heap_allocator.allocate != nullptr)) {
+    return heap_allocator.allocate(size);
+  }
+  NoteDefaultHeapAllocation();
+  return ::operator new(size);
+}
+
+// Like AllocateHeap(), but returns nullptr instead of throwing.
+inline void* AllocateHeapNoThrow(size_t size) noexcept {
+  if (PROTOBUF_PREDICT_FALSE(heap_allocator.allocate != nullptr)) {
+    return heap_allocator.allocate(size);
+  }
+  NoteDefaultHeapAllocation();
+  return ::operator new(size, std::nothrow);
+}
+
+// Like AllocateHeap(), but with the semantics of AllocateAtLeast(). The
+// returned size must be passed to DeallocateHeap().
+inline SizedPtr AllocateHeapAtLeast(size_t size) {
+  if (PROTOBUF_PREDICT_FALSE(heap_allocator.allocate != nullptr)) {
+    return {heap_allocator.allocate(size), size};
+  }
+  NoteDefaultHeapAllocation();
+  return AllocateAtLeast(size);
+}
+
+inline void DeallocateHeap(void* p, size_t size) {
+  if (PROTOBUF_PREDICT_FALSE(heap_allocator.deallocate != nullptr)) {
+    heap_allocator.deallocate(p, size);
+    return;
+  }
+  SizedDelete(p, size);
+}
+
+// Like DeallocateHeap(), for the rare callers that do not know the size.
+inline void DeallocateHeapUnsized(void* p) noexcept {
+  if (PROTOBUF_PREDICT_FALSE(heap_allocator.deallocate != nullptr)) {
+    heap_allocator.deallocate(p, 0);
+    return;
+  }
+  ::operator delete(p);
+}
+
+}  // namespace internal
+
 // Arena allocator. Arena allocation replaces ordinary (heap-based) allocation
 // with new/delete, and improves performance by aggregating allocations into
 // larger blocks and freeing allocations all at once. Protocol messages are
@@ -34,8 +34,10 @@
 #include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <new>
 #include <string>
 #include <thread>
 #include <type_traits>
@@ -49,6 +51,7 @@
 #include "absl/synchronization/barrier.h"
 #include "google/protobuf/arena_test_util.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/extension_set.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
@@ -1566,6 +1569,116 @@ TEST(ArenaTest, SpaceReusePoisonsAndUnpoisonsMemory) {
 #endif  // ADDRESS_SANITIZER
 }
 
+#if GTEST_HAS_DEATH_TEST
+namespace {
+size_t heap_allocations = 0;
+size_t heap_deallocations = 0;
+size_t heap_bytes = 0;
+
+void* CountingAllocate(size_t size) {
+  ++heap_allocations;
+  heap_bytes += size;
+  return ::operator new(size);
+}
+
+void CountingDeallocate(void* p, size_t size) {
+  ++heap_deallocations;
+  heap_bytes -= size;
+  ::operator delete(p, size);
+}
+
+// The allocator can only be installed once per process, and only before any
+// message has allocated memory. Death test children of this style start the
+// binary afresh instead of forking this process, which has run other tests.
+void UseFreshDeathTestProcess() {
+#ifdef GTEST_FLAG_SET
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+#else
+  ::testing::GTEST_FLAG(death_test_style) = "threadsafe";
+#endif
+}
+}  // namespace
+
+// Each test installs the allocator in a death test child and reports through
+// the exit code.
+TEST(HeapAllocatorTest, RoutesHeapMessagesAndFields) {
+  UseFreshDeathTestProcess();
+  EXPECT_EXIT(
+      {
+        HeapAllocator allocator;
+        allocator.allocate = CountingAllocate;
+        allocator.deallocate = CountingDeallocate;
+        SetHeapAllocator(allocator);
+
+        auto* message = new TestAllTypes;
+        TestUtil::SetAllFields(message);
+        message->mutable_repeated_int32()->Reserve(100);
+        ABSL_CHECK_GT(heap_allocations, 0u);
+        delete message;
+        ABSL_CHECK_EQ(heap_allocations, heap_deallocations);
+        ABSL_CHECK_EQ(heap_bytes, 0u);
+
+        // `new (std::nothrow)` goes through the allocator as well.
+        heap_allocations = 0;
+        delete new (std::nothrow) TestAllTypes;
+        ABSL_CHECK_EQ(heap_allocations, 1u);
+
+        // Nothing on an arena goes through the allocator.
+        heap_allocations = 0;
+        {
+          Arena arena;
+          auto* arena_message = Arena::CreateMessage<TestAllTypes>(&arena);
+          TestUtil::SetAllFields(arena_message);
+        }
+        ABSL_CHECK_EQ(heap_allocations, 0u);
+
+        // Dynamic messages and their prototypes go through it too.
+        heap_allocations = heap_deallocations = 0;
+        {
+          DynamicMessageFactory factory;
+          std::unique_ptr<Message> dynamic(
+              factory.GetPrototype(TestAllTypes::descriptor())->New());
+          TestUtil::ReflectionTester(TestAllTypes::descriptor())
+              .SetAllFieldsViaReflection(dynamic.get());
+        }
+        ABSL_CHECK_GT(heap_allocations, 0u);
+        ABSL_CHECK_EQ(heap_allocations, heap_deallocations);
+        std::_Exit(0);
+      },
+      ::testing::ExitedWithCode(0), "");
+}
+
+TEST(HeapAllocatorTest, NeedsBothFunctions) {
+  HeapAllocator allocator;
+  allocator.allocate = CountingAllocate;
+  EXPECT_DEATH(SetHeapAllocator(allocator), "needs both");
+}
+
+TEST(HeapAllocatorTest, InstalledOnlyOnce) {
+  UseFreshDeathTestProcess();
+  HeapAllocator allocator;
+  allocator.allocate = CountingAllocate;
+  allocator.deallocate = CountingDeallocate;
+  EXPECT_DEATH(
+      {
+        SetHeapAllocator(allocator);
+        SetHeapAllocator(allocator);
+      },
+      "only be called once");
+}
+
+TEST(HeapAllocatorTest, InstalledBeforeAnyAllocation) {
+  HeapAllocator allocator;
+  allocator.allocate = CountingAllocate;
+  allocator.deallocate = CountingDeallocate;
+  EXPECT_DEATH(
+      {
+        delete new TestAllTypes;
+        SetHeapAllocator(allocator);
+      },
+      "before any message");
+}
+#endif  // GTEST_HAS_DEATH_TEST
 
 }  // namespace protobuf
 }  // namespace google
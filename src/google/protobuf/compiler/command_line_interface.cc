@@ -2047,6 +2047,34 @@ CommandLineInterface::InterpretArgument(const std::string& name,
 
     plugins_[plugin_name] = path;
 
+  } else if (name == "--plugin_request") {
+    if (plugin_prefix_.empty()) {
+      std::cerr << "This compiler does not support plugins." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+
+    std::string::size_type equals_pos = value.find_first_of('=');
+    if (equals_pos == std::string::npos || equals_pos == 0) {
+      std::cerr << name << " requires a value of the form NAME=OPTIONS."
+                << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+
+    PluginRequestOptions* options =
+        &plugin_request_options_[value.substr(0, equals_pos)];
+    for (absl::string_view option :
+         absl::StrSplit(absl::string_view(value).substr(equals_pos + 1), ',',
+                        absl::SkipEmpty())) {
+      if (option == "direct_deps_only") {
+        options->direct_dependencies_only = true;
+      } else if (option == "no_dep_source_info") {
+        options->dependency_source_info = false;
+      } else {
+        std::cerr << "Unknown " << name << " option: " << option << std::endl;
+        return PARSE_ARGUMENT_FAIL;
+      }
+    }
+
   } else if (name == "--print_free_field_numbers") {
     if (mode_ != MODE_COMPILE) {
       std::cerr << "Cannot use " << name
@@ -2217,7 +2245,19 @@ Parse PROTO_FILES and generate output based on the options given:
                               Additionally, EXECUTABLE may be of the form
                               NAME=PATH, in which case the given plugin name
                               is mapped to the given executable even if
-                              the executable's own name differs.)";
+                              the executable's own name differs.
+  --plugin_request=NAME=OPTIONS
+                              Controls which descriptors are sent to the
+                              plugin NAME.  OPTIONS is a comma-separated
+                              list of:
+                                direct_deps_only: only send the direct
+                                  imports of the files to generate (and
+                                  their public imports) rather than all
+                                  transitive dependencies.  The plugin must
+                                  tolerate unknown dependencies.
+                                no_dep_source_info: only send
+                                  SourceCodeInfo for the files to
+                                  generate.)";
   }
 
   for (const auto& kv : generators_by_flag_name_) {
@@ -2407,13 +2447,43 @@ bool CommandLineInterface::GeneratePluginOutput(
   }
 
 
+  PluginRequestOptions request_options;
+  auto options_it = plugin_request_options_.find(plugin_name);
+  if (options_it != plugin_request_options_.end()) {
+    request_options = options_it->second;
+  }
+
+  absl::flat_hash_set<const FileDescriptor*> files_to_generate(
+      parsed_files.begin(), parsed_files.end());
   absl::flat_hash_set<const FileDescriptor*> already_seen;
   for (int i = 0; i < parsed_files.size(); i++) {
     request.add_file_to_generate(parsed_files[i]->name());
-    GetTransitiveDependencies(parsed_files[i],
-                              true,  // Include json_name for plugins.
-                              true,  // Include source code info.
-                              &already_seen, request.mutable_proto_file());
+    if (request_options.direct_dependencies_only) {
+      GetDirectDependencies(parsed_files[i], files_to_generate,
+                            true,  // Include json_name for plugins.
+                            request_options.dependency_source_info,
+                            &already_seen, request.mutable_proto_file());
+    } else {
+      GetTransitiveDependencies(parsed_files[i],
+                                true,  // Include json_name for plugins.
+                                request_options.dependency_source_info,
+                                &already_seen, request.mutable_proto_file());
+    }
+  }
+
+  if (!request_options.dependency_source_info) {
+    // The files to generate always carry their source code info; it is only
+    // omitted for dependencies.
+    absl::flat_hash_map<absl::string_view, const FileDescriptor*> by_name;
+    for (const FileDescriptor* file : parsed_files) {
+      by_name[file->name()] = file;
+    }
+    for (FileDescriptorProto& file_proto : *request.mutable_proto_file()) {
+      auto it = by_name.find(file_proto.name());
+      if (it != by_name.end()) {
+        it->second->CopySourceCodeInfoTo(&file_proto);
+      }
+    }
   }
 
   google::protobuf::compiler::Version* version =
@@ -2644,6 +2714,44 @@ void CommandLineInterface::GetTransitiveDependencies(
   }
 }
 
+void CommandLineInterface::GetDirectDependencies(
+    const FileDescriptor* file,
+    const absl::flat_hash_set<const FileDescriptor*>& files_to_generate,
+    bool include_json_name, bool include_source_code_info,
+    absl::flat_hash_set<const FileDescriptor*>* already_seen,
+    RepeatedPtrField<FileDescriptorProto>* output) {
+  if (!already_seen->insert(file).second) {
+    // Already saw this file.  Skip.
+    return;
+  }
+
+  // Files being generated need all of their imports; anything else only needs
+  // the files it re-exports.
+  if (files_to_generate.contains(file)) {
+    for (int i = 0; i < file->dependency_count(); i++) {
+      GetDirectDependencies(file->dependency(i), files_to_generate,
+                            include_json_name, include_source_code_info,
+                            already_seen, output);
+    }
+  } else {
+    for (int i = 0; i < file->public_dependency_count(); i++) {
+      GetDirectDependencies(file->public_dependency(i), files_to_generate,
+                            include_json_name, include_source_code_info,
+                            already_seen, output);
+    }
+  }
+
+  // Add this file.
+  FileDescriptorProto* new_descriptor = output->Add();
+  *new_descriptor = StripSourceRetentionOptions(*file);
+  if (include_json_name) {
+    file->CopyJsonNameTo(new_descriptor);
+  }
+  if (include_source_code_info) {
+    file->CopySourceCodeInfoTo(new_descriptor);
+  }
+}
+
 const CommandLineInterface::GeneratorInfo*
 CommandLineInterface::FindGeneratorByFlag(const std::string& name) const {
   auto it = generators_by_flag_name_.find(name);
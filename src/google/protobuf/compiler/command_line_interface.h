@@ -324,6 +324,18 @@ class PROTOC_EXPORT CommandLineInterface {
       absl::flat_hash_set<const FileDescriptor*>* already_seen,
       RepeatedPtrField<FileDescriptorProto>* output);
 
+  // Like GetTransitiveDependencies(), but only follows the imports a plugin
+  // needs to see the types used by the files it generates: every direct import
+  // of a file in files_to_generate, and the public imports of anything added
+  // that way.  Files imported only indirectly are left out, so the protos can
+  // only be built in a pool that allows unknown dependencies.
+  static void GetDirectDependencies(
+      const FileDescriptor* file,
+      const absl::flat_hash_set<const FileDescriptor*>& files_to_generate,
+      bool include_json_name, bool include_source_code_info,
+      absl::flat_hash_set<const FileDescriptor*>* already_seen,
+      RepeatedPtrField<FileDescriptorProto>* output);
+
   // Implements the --print_free_field_numbers. This function prints free field
   // numbers into stdout for the message and it's nested message types in
   // post-order, i.e. nested types first. Printed range are left-right
@@ -377,6 +389,21 @@ class PROTOC_EXPORT CommandLineInterface {
   // PATH (or other OS-specific search strategy) is searched.
   absl::flat_hash_map<std::string, std::string> plugins_;
 
+  // Controls how much of the import graph is sent to a plugin in its
+  // CodeGeneratorRequest.  Set with --plugin_request=NAME=OPTIONS.
+  struct PluginRequestOptions {
+    // Only send the direct imports of the files to generate (and their public
+    // imports) instead of all transitive dependencies.
+    bool direct_dependencies_only = false;
+    // Send SourceCodeInfo for dependencies as well as for the files to
+    // generate.
+    bool dependency_source_info = true;
+  };
+
+  // Maps plugin names, as used in plugins_, to their request options.
+  absl::flat_hash_map<std::string, PluginRequestOptions>
+      plugin_request_options_;
+
   // Stuff parsed from command line.
   enum Mode {
     MODE_COMPILE,  // Normal mode:  parse .proto files and compile them.
@@ -2292,6 +2292,134 @@ TEST_F(CommandLineInterfaceTest, PluginReceivesJsonName) {
   ExpectErrorSubstring("Saw json_name: true");
 }
 
+TEST_F(CommandLineInterfaceTest, PluginReceivesDependencySourceCodeInfo) {
+  CreateTempFile("bar.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Bar {}\n");
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "import \"bar.proto\";\n"
+                 "message MockCodeGenerator_DependencyHasSourceCodeInfo {}\n");
+
+  Run("protocol_compiler --plug_out=$tmpdir --proto_path=$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Saw dependency source code info: true.");
+}
+
+TEST_F(CommandLineInterfaceTest, PluginRequestWithoutDependencySourceInfo) {
+  CreateTempFile("bar.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Bar {}\n");
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "import \"bar.proto\";\n"
+                 "message MockCodeGenerator_DependencyHasSourceCodeInfo {}\n");
+
+  Run("protocol_compiler --plug_out=$tmpdir --proto_path=$tmpdir "
+      "--plugin_request=prefix-gen-plug=no_dep_source_info foo.proto");
+
+  ExpectErrorSubstring("Saw dependency source code info: false.");
+}
+
+TEST_F(CommandLineInterfaceTest, PluginRequestKeepsSourceInfoOfGeneratedFiles) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message MockCodeGenerator_HasSourceCodeInfo {}\n");
+
+  Run("protocol_compiler --plug_out=$tmpdir --proto_path=$tmpdir "
+      "--plugin_request=prefix-gen-plug=no_dep_source_info foo.proto");
+
+  ExpectErrorSubstring(
+      "Saw message type MockCodeGenerator_HasSourceCodeInfo: true.");
+}
+
+TEST_F(CommandLineInterfaceTest, PluginRequestDirectDependenciesOnly) {
+  // Public imports of a direct dependency must still be sent, since the types
+  // they define are visible to the files being generated.
+  CreateTempFile("baz.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Baz {}\n");
+  CreateTempFile("bar.proto",
+                 "syntax = \"proto2\";\n"
+                 "import public \"baz.proto\";\n"
+                 "message Bar {}\n");
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "import \"bar.proto\";\n"
+                 "message Foo {\n"
+                 "  optional Bar bar = 1;\n"
+                 "  optional Baz baz = 2;\n"
+                 "}\n");
+
+  Run("protocol_compiler --plug_out=$tmpdir --proto_path=$tmpdir "
+      "--plugin_request=prefix-gen-plug=direct_deps_only,no_dep_source_info "
+      "foo.proto");
+
+  ExpectNoErrors();
+  ExpectGenerated("test_plugin", "", "foo.proto", "Foo");
+}
+
+TEST_F(CommandLineInterfaceTest, PluginRequestOmitsPrivateImportsOfDeps) {
+  CreateTempFile("qux.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Qux {}\n");
+  CreateTempFile("bar.proto",
+                 "syntax = \"proto2\";\n"
+                 "import \"qux.proto\";\n"
+                 "message Bar {\n"
+                 "  optional Qux qux = 1;\n"
+                 "}\n");
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "import \"bar.proto\";\n"
+                 "message Foo {\n"
+                 "  optional Bar bar = 1;\n"
+                 "}\n");
+
+  // The plugin still builds the request and generates code.
+  Run("protocol_compiler --plug_out=$tmpdir --proto_path=$tmpdir "
+      "--plugin_request=prefix-gen-plug=direct_deps_only foo.proto");
+
+  ExpectNoErrors();
+  ExpectGenerated("test_plugin", "", "foo.proto", "Foo");
+}
+
+TEST_F(CommandLineInterfaceTest, PluginRequestOmitsTransitiveDependency) {
+  CreateTempFile("qux.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Qux {}\n");
+  CreateTempFile("bar.proto",
+                 "syntax = \"proto2\";\n"
+                 "import \"qux.proto\";\n"
+                 "message Bar {\n"
+                 "  optional Qux qux = 1;\n"
+                 "}\n");
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "import \"bar.proto\";\n"
+                 "message MockCodeGenerator_TransitiveDependencySent {\n"
+                 "  optional Bar bar = 1;\n"
+                 "}\n");
+
+  Run("protocol_compiler --plug_out=$tmpdir --proto_path=$tmpdir foo.proto");
+  ExpectErrorSubstring("Saw transitive dependency: yes.");
+
+  Run("protocol_compiler --plug_out=$tmpdir --proto_path=$tmpdir "
+      "--plugin_request=prefix-gen-plug=direct_deps_only foo.proto");
+  ExpectErrorSubstring("Saw transitive dependency: no.");
+}
+
+TEST_F(CommandLineInterfaceTest, PluginRequestUnknownOption) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+
+  Run("protocol_compiler --plug_out=$tmpdir --proto_path=$tmpdir "
+      "--plugin_request=prefix-gen-plug=bogus foo.proto");
+
+  ExpectErrorText("Unknown --plugin_request option: bogus\n");
+}
+
 TEST_F(CommandLineInterfaceTest, PluginReceivesCompilerVersion) {
   CreateTempFile("foo.proto",
                  "syntax = \"proto2\";\n"
@@ -35,13 +35,17 @@
 #include "google/protobuf/compiler/cpp/generator.h"
 
 #include <cstdlib>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/compiler/cpp/file.h"
 #include "google/protobuf/compiler/cpp/helpers.h"
@@ -53,6 +57,34 @@ namespace compiler {
 namespace cpp {
 namespace {
 
+// Reads a field presence profile: one "<full field name> <fraction>" pair per
+// line, where the fraction is how often the field was seen set in sampled
+// messages.  Blank lines and lines starting with '#' are ignored.
+bool LoadFieldPresenceProfile(const std::string& path, Options* options,
+                              std::string* error) {
+  std::ifstream profile(path);
+  if (!profile.is_open()) {
+    *error = absl::StrCat("Could not open field presence profile: ", path);
+    return false;
+  }
+  std::string line;
+  for (int line_number = 1; std::getline(profile, line); ++line_number) {
+    absl::string_view entry = absl::StripAsciiWhitespace(line);
+    if (entry.empty() || entry[0] == '#') continue;
+    std::vector<absl::string_view> parts =
+        absl::StrSplit(entry, absl::ByAnyChar(" \t"), absl::SkipEmpty());
+    float presence;
+    if (parts.size() != 2 || !absl::SimpleAtof(parts[1], &presence) ||
+        !(presence >= 0 && presence <= 1)) {
+      *error = absl::StrCat(path, ":", line_number,
+                            ": expected \"<field> <fraction in [0, 1]>\"");
+      return false;
+    }
+    options->field_presence[parts[0]] = presence;
+  }
+  return true;
+}
+
 std::string NumberedCcFileName(absl::string_view basename, int number) {
   return absl::StrCat(basename, ".out/", number, ".cc");
 }
@@ -162,6 +194,18 @@ bool CppGenerator::Generate(const FileDescriptor* file,
     } else if (key == "proto_static_reflection_h") {
     } else if (key == "annotate_accessor") {
       file_options.annotate_accessor = true;
+    } else if (key == "annotate_fast_table_coverage") {
+      file_options.annotate_fast_table_coverage = true;
+    } else if (key == "cold_fields") {
+      // Fields that are almost never set; they get no fast parsing entry.
+      for (absl::string_view field :
+           absl::StrSplit(value, ':', absl::SkipEmpty())) {
+        file_options.field_presence[field] = 0;
+      }
+    } else if (key == "field_presence_profile") {
+      if (!LoadFieldPresenceProfile(value, &file_options, error)) {
+        return false;
+      }
     } else if (key == "protos_for_field_listener_events") {
       for (absl::string_view proto : absl::StrSplit(value, ':')) {
         if (proto == file->name()) {
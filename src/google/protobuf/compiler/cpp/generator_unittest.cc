@@ -0,0 +1,215 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <string>
+
+#include "google/protobuf/testing/file.h"
+#include "google/protobuf/compiler/cpp/generator.h"
+#include "google/protobuf/compiler/command_line_interface.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/testing/googletest.h"
+#include <gtest/gtest.h>
+#include "absl/log/absl_check.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/compiler/annotation_test_util.h"
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+namespace cpp {
+
+namespace atu = annotation_test_util;
+
+namespace {
+
+class CppGeneratorTest : public ::testing::Test {
+ protected:
+  // Runs the C++ generator with `parameter` on test.proto and returns the
+  // generated .pb.cc.
+  std::string GenerateSource(absl::string_view parameter) {
+    return Generate(parameter, "test.pb.cc");
+  }
+
+  // Same as above, returning the generated .pb.h.
+  std::string GenerateHeader(absl::string_view parameter) {
+    return Generate(parameter, "test.pb.h");
+  }
+
+  // Writes `contents` to a temporary file and returns its path.
+  std::string WriteTempFile(absl::string_view name,
+                            absl::string_view contents) {
+    std::string path = absl::StrCat(TestTempDir(), "/", name);
+    ABSL_CHECK_OK(File::SetContents(path, contents, true));
+    return path;
+  }
+
+ private:
+  std::string Generate(absl::string_view parameter,
+                       absl::string_view output) {
+    CommandLineInterface cli;
+    CppGenerator cpp_generator;
+    cli.RegisterGenerator("--cpp_out", &cpp_generator, "");
+    FileDescriptorProto file;
+    EXPECT_TRUE(atu::RunProtoCompiler(
+        "test.proto", absl::StrCat("--cpp_out=", parameter, ":", TestTempDir()),
+        &cli, &file));
+    std::string contents;
+    ABSL_CHECK_OK(File::GetContents(absl::StrCat(TestTempDir(), "/", output),
+                                    &contents, true));
+    return contents;
+  }
+};
+
+// Returns true if the field declared as `declaration` has a fast-table entry,
+// i.e. if its field comment is followed by a TcParser fast-path function.
+bool HasFastEntry(absl::string_view pb_cc, absl::string_view declaration) {
+  std::string comment = absl::StrCat("// ", declaration, "\n");
+  for (size_t pos = pb_cc.find(comment); pos != absl::string_view::npos;
+       pos = pb_cc.find(comment, pos + 1)) {
+    absl::string_view entry = absl::StripLeadingAsciiWhitespace(
+        pb_cc.substr(pos + comment.size()));
+    if (absl::StartsWith(entry, "{::_pbi::TcParser::")) return true;
+  }
+  return false;
+}
+
+// Fields 17 and 33 map to the same entry in any fast table this message can
+// have.
+constexpr absl::string_view kCollidingFieldsFile = R"(
+  syntax = "proto2";
+  package foo;
+  message Message {
+    optional int32 first = 17;
+    optional int32 second = 33;
+  }
+)";
+
+TEST_F(CppGeneratorTest, FastTableCoverage) {
+  atu::AddFile("test.proto", kCollidingFieldsFile);
+  std::string pb_cc = GenerateSource(
+      "experimental_tail_call_table_mode=always,annotate_fast_table_coverage");
+  EXPECT_NE(pb_cc.find("// Fast table: entries for 1 of 2 fields "
+                       "(2 eligible).\n"),
+            std::string::npos)
+      << pb_cc;
+  // The lower field number wins the collision.
+  EXPECT_TRUE(HasFastEntry(pb_cc, "optional int32 first = 17;"));
+  EXPECT_FALSE(HasFastEntry(pb_cc, "optional int32 second = 33;"));
+}
+
+TEST_F(CppGeneratorTest, ColdFieldsGetNoFastEntry) {
+  atu::AddFile("test.proto", kCollidingFieldsFile);
+  std::string pb_cc = GenerateSource(
+      "experimental_tail_call_table_mode=always,annotate_fast_table_coverage,"
+      "cold_fields=foo.Message.first");
+  EXPECT_NE(pb_cc.find("// Fast table: entries for 1 of 2 fields "
+                       "(1 eligible).\n"),
+            std::string::npos)
+      << pb_cc;
+  EXPECT_FALSE(HasFastEntry(pb_cc, "optional int32 first = 17;"));
+  EXPECT_TRUE(HasFastEntry(pb_cc, "optional int32 second = 33;"));
+}
+
+TEST_F(CppGeneratorTest, PresenceProfileDecidesCollisions) {
+  atu::AddFile("test.proto", kCollidingFieldsFile);
+  std::string profile = WriteTempFile("presence_profile.txt", R"(
+    # field          presence
+    foo.Message.first  0.1
+    foo.Message.second 0.9
+  )");
+  std::string pb_cc = GenerateSource(absl::StrCat(
+      "experimental_tail_call_table_mode=always,field_presence_profile=",
+      profile));
+  EXPECT_FALSE(HasFastEntry(pb_cc, "optional int32 first = 17;"));
+  EXPECT_TRUE(HasFastEntry(pb_cc, "optional int32 second = 33;"));
+}
+
+TEST_F(CppGeneratorTest, PresenceProfileOrdersHasbits) {
+  // 32 fields fill the first has_bits_ word, so without a profile `hot` gets
+  // a hasbit in the second word.
+  std::string fields;
+  for (int i = 1; i <= 32; ++i) {
+    absl::StrAppend(&fields, "optional int32 f", i, " = ", i, ";\n");
+  }
+  atu::AddFile("test.proto",
+               absl::StrCat("syntax = \"proto2\";\n"
+                            "package foo;\n"
+                            "message Message {\n",
+                            fields, "optional int32 hot = 300;\n}\n"));
+  const std::string has_hot = "::has_hot() const {\n";
+
+  std::string pb_h = GenerateHeader("");
+  size_t pos = pb_h.find(has_hot);
+  ASSERT_NE(pos, std::string::npos);
+  EXPECT_TRUE(absl::StartsWith(
+      absl::StripLeadingAsciiWhitespace(pb_h.substr(pos + has_hot.size())),
+      "bool value = (_impl_._has_bits_[1] & 0x00000001u) != 0;"));
+
+  // Once f1 is known to be rare, `hot` moves into the first word.
+  std::string profile =
+      WriteTempFile("presence_profile.txt", "foo.Message.f1 0.01\n");
+  pb_h = GenerateHeader(absl::StrCat("field_presence_profile=", profile));
+  pos = pb_h.find(has_hot);
+  ASSERT_NE(pos, std::string::npos);
+  EXPECT_TRUE(absl::StartsWith(
+      absl::StripLeadingAsciiWhitespace(pb_h.substr(pos + has_hot.size())),
+      "bool value = (_impl_._has_bits_[0] & 0x80000000u) != 0;"));
+}
+
+TEST_F(CppGeneratorTest, MalformedPresenceProfile) {
+  atu::AddFile("test.proto", kCollidingFieldsFile);
+  std::string profile =
+      WriteTempFile("presence_profile.txt", "foo.Message.first often\n");
+  CommandLineInterface cli;
+  CppGenerator cpp_generator;
+  cli.RegisterGenerator("--cpp_out", &cpp_generator, "");
+  FileDescriptorProto file;
+  EXPECT_FALSE(atu::RunProtoCompiler(
+      "test.proto",
+      absl::StrCat("--cpp_out=field_presence_profile=", profile, ":",
+                   TestTempDir()),
+      &cli, &file));
+}
+
+TEST_F(CppGeneratorTest, NoCoverageCommentByDefault) {
+  atu::AddFile("test.proto", kCollidingFieldsFile);
+  std::string pb_cc =
+      GenerateSource("experimental_tail_call_table_mode=always");
+  EXPECT_EQ(pb_cc.find("// Fast table:"), std::string::npos);
+}
+
+}  // namespace
+}  // namespace cpp
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
@@ -902,6 +902,11 @@ std::string SafeFunctionName(const Descriptor* descriptor,
 bool IsProfileDriven(const Options& options) {
   return options.access_info_map != nullptr;
 }
+
+float FieldPresence(const FieldDescriptor* field, const Options& options) {
+  auto it = options.field_presence.find(field->full_name());
+  return it == options.field_presence.end() ? 1.0f : it->second;
+}
 bool IsStringInlined(const FieldDescriptor* descriptor,
                      const Options& options) {
   (void)descriptor;
@@ -344,6 +344,11 @@ inline bool IsWeak(const FieldDescriptor* field, const Options& options) {
 
 bool IsProfileDriven(const Options& options);
 
+// Returns the estimated fraction of parsed messages that contain `field`, as
+// given by the cold_fields or field_presence_profile generator options, or 1
+// if no estimate is known.
+float FieldPresence(const FieldDescriptor* field, const Options& options);
+
 bool IsStringInlined(const FieldDescriptor* descriptor, const Options& options);
 
 // For a string field, returns the effective ctype.  If the actual ctype is
@@ -550,14 +550,28 @@ MessageGenerator::MessageGenerator(
   message_layout_helper_->OptimizeLayout(&optimized_order_, options_,
                                          scc_analyzer_);
 
-  // This message has hasbits iff one or more fields need one.
+  // This message has hasbits iff one or more fields need one.  Hasbits follow
+  // the layout order unless presence estimates are given, in which case the
+  // likeliest fields come first: they then share the leading has_bits_ words
+  // and stay within the 32 hasbits that fast parsing entries can update.
+  std::vector<const FieldDescriptor*> hasbit_order;
   for (auto field : optimized_order_) {
-    if (HasHasbit(field)) {
-      if (has_bit_indices_.empty()) {
-        has_bit_indices_.resize(descriptor_->field_count(), kNoHasbit);
-      }
-      has_bit_indices_[field->index()] = max_has_bit_index_++;
+    if (HasHasbit(field)) hasbit_order.push_back(field);
+  }
+  if (!options_.field_presence.empty()) {
+    std::stable_sort(hasbit_order.begin(), hasbit_order.end(),
+                     [&](const FieldDescriptor* a, const FieldDescriptor* b) {
+                       return FieldPresence(a, options_) >
+                              FieldPresence(b, options_);
+                     });
+  }
+  for (auto field : hasbit_order) {
+    if (has_bit_indices_.empty()) {
+      has_bit_indices_.resize(descriptor_->field_count(), kNoHasbit);
     }
+    has_bit_indices_[field->index()] = max_has_bit_index_++;
+  }
+  for (auto field : optimized_order_) {
     if (IsStringInlined(field, options_)) {
       if (inlined_string_indices_.empty()) {
         inlined_string_indices_.resize(descriptor_->field_count(), kNoHasbit);
@@ -2362,7 +2376,10 @@ void MessageGenerator::GenerateSharedDestructorCode(io::Printer* p) {
         field_generators_.get(field).GenerateDestructorCode(p);
       }
     }
-    format("delete $cached_split_ptr$;\n");
+    // Allocated by CreateSplitMessageGeneric().
+    format(
+        "$cached_split_ptr$->~Split();\n"
+        "::_pbi::DeallocateHeap($cached_split_ptr$, sizeof(Impl_::Split));\n");
     format.Outdent();
     format("}\n");
   }
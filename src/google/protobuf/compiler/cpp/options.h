@@ -35,6 +35,7 @@
 
 #include <string>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 
 namespace google {
@@ -66,6 +67,9 @@ struct Options {
   std::string annotation_pragma_name;
   std::string annotation_guard_name;
   FieldListenerOptions field_listener_options;
+  // Estimated fraction of parsed messages containing each field, by full
+  // field name. Fields not listed are assumed to always be present.
+  absl::flat_hash_map<std::string, float> field_presence;
   EnforceOptimizeMode enforce_mode = EnforceOptimizeMode::kNoEnforcement;
   enum {
     kTCTableNever,
@@ -81,6 +85,7 @@ struct Options {
   bool bootstrap = false;
   bool opensource_runtime = false;
   bool annotate_accessor = false;
+  bool annotate_fast_table_coverage = false;
   bool unverified_lazy_message_sets = false;
   bool profile_driven_inline_string = true;
   bool force_split = false;
@@ -106,6 +106,7 @@ class ParseFunctionGenerator::GeneratedOptionProvider final
             FileOptions::LITE_RUNTIME,
         ShouldSplit(field, gen_->options_),
         /* uses_codegen */ true,
+        FieldPresence(field, gen_->options_),
     };
   }
 
@@ -471,6 +472,16 @@ void ParseFunctionGenerator::GenerateTailCallTable(Formatter& format) {
   // the table is sufficient we can use a generic routine, that just handles
   // unknown fields and potentially an extension range.
   auto field_num_to_entry_table = MakeNumToEntryTable(ordered_fields_);
+  if (options_.annotate_fast_table_coverage) {
+    int num_fast_fields = 0;
+    for (const auto& info : tc_table_info_->fast_path_fields) {
+      if (info.field != nullptr) ++num_fast_fields;
+    }
+    format(
+        "// Fast table: entries for $1$ of $2$ fields ($3$ eligible).\n",
+        num_fast_fields, ordered_fields_.size(),
+        tc_table_info_->num_fast_eligible_fields);
+  }
   format(
       "PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1\n"
       "const ::_pbi::TcParseTable<$1$, $2$, $3$, $4$, $5$> "
@@ -236,6 +236,20 @@ bool MockCodeGenerator::Generate(const FileDescriptor* file,
         ABSL_LOG(FATAL)
             << "Saw message type MockCodeGenerator_HasSourceCodeInfo: "
             << has_source_code_info << ".";
+      } else if (command == "DependencyHasSourceCodeInfo") {
+        FileDescriptorProto file_descriptor_proto;
+        file->dependency(0)->CopySourceCodeInfoTo(&file_descriptor_proto);
+        bool has_source_code_info =
+            file_descriptor_proto.has_source_code_info() &&
+            file_descriptor_proto.source_code_info().location_size() > 0;
+        ABSL_LOG(FATAL) << "Saw dependency source code info: "
+                        << has_source_code_info << ".";
+      } else if (command == "TransitiveDependencySent") {
+        // A left out import is built as a placeholder file without types.
+        const FileDescriptor* transitive = file->dependency(0)->dependency(0);
+        ABSL_LOG(FATAL) << "Saw transitive dependency: "
+                        << (transitive->message_type_count() > 0 ? "yes" : "no")
+                        << ".";
       } else if (command == "HasJsonName") {
         FieldDescriptorProto field_descriptor_proto;
         file->message_type(i)->field(0)->CopyTo(&field_descriptor_proto);
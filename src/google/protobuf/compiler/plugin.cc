@@ -33,6 +33,7 @@
 #include "google/protobuf/compiler/plugin.h"
 
 #include <iostream>
+#include <string>
 #ifdef _WIN32
 #include <fcntl.h>
 #else
@@ -40,6 +41,9 @@
 #endif
 
 #include "google/protobuf/compiler/plugin.pb.h"
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/compiler/code_generator.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
@@ -112,6 +116,20 @@ bool GenerateCode(const CodeGeneratorRequest& request,
                   const CodeGenerator& generator,
                   CodeGeneratorResponse* response, std::string* error_msg) {
   DescriptorPool pool;
+  // With --plugin_request=NAME=direct_deps_only, protoc leaves out the
+  // imports of dependencies that are not re-exported, so tolerate them.
+  absl::flat_hash_set<absl::string_view> sent_files;
+  for (const FileDescriptorProto& file : request.proto_file()) {
+    sent_files.insert(file.name());
+  }
+  for (const FileDescriptorProto& file : request.proto_file()) {
+    if (!absl::c_all_of(file.dependency(), [&](const std::string& name) {
+          return sent_files.contains(name);
+        })) {
+      pool.AllowUnknownDependencies();
+      break;
+    }
+  }
   for (int i = 0; i < request.proto_file_size(); i++) {
     const FileDescriptor* file = pool.BuildFile(request.proto_file(i));
     if (file == nullptr) {
@@ -1981,6 +1981,25 @@ const FileDescriptor* DescriptorPool::FindFileByName(
   return nullptr;
 }
 
+bool DescriptorPool::BuildAllFilesFromDatabase() const {
+  if (fallback_database_ == nullptr) return false;
+  std::vector<std::string> file_names;
+  {
+    // The database is only ever queried under the pool's lock: lookups may
+    // mutate its indices, and FindFileByName() can run concurrently.
+    absl::MutexLockMaybe lock(mutex_);
+    if (!fallback_database_->FindAllFileNames(&file_names)) return false;
+  }
+
+  // Build the files one at a time so that concurrent lookups only ever wait
+  // for a single file.
+  bool success = true;
+  for (const std::string& file_name : file_names) {
+    if (FindFileByName(file_name) == nullptr) success = false;
+  }
+  return success;
+}
+
 const FileDescriptor* DescriptorPool::FindFileContainingSymbol(
     absl::string_view symbol_name) const {
   absl::MutexLockMaybe lock(mutex_);
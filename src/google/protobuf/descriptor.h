@@ -1904,6 +1904,16 @@ class PROTOBUF_EXPORT DescriptorPool {
   void FindAllExtensions(const Descriptor* extendee,
                          std::vector<const FieldDescriptor*>* out) const;
 
+  // Builds every file listed by the fallback database's FindAllFileNames(),
+  // so that later lookups never have to parse and cross-link a file on
+  // demand.  Files are otherwise built lazily the first time they are looked
+  // up, which for generated_pool() means on the first call to descriptor() or
+  // GetReflection() of a generated type.  Calling this on generated_pool() at
+  // startup moves that cost off of the first request.  Returns false if there
+  // is no fallback database, the database can't list its files, or some file
+  // failed to build.
+  bool BuildAllFilesFromDatabase() const;
+
   // Building descriptors --------------------------------------------
 
   // When converting a FileDescriptorProto to a FileDescriptor, various
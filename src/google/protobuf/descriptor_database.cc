@@ -35,15 +35,18 @@
 #include "google/protobuf/descriptor_database.h"
 
 #include <algorithm>
+#include <atomic>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.pb.h"
 
 
@@ -189,6 +192,30 @@ typename Container::const_iterator FindLastLessOrEqual(
   return iter;
 }
 
+// Hashes names one character at a time, so that the hashes of all the
+// '.'-separated prefixes of a name come out of a single pass over it.
+class NameHasher {
+ public:
+  void Update(char c) {
+    state_ = (state_ ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+  }
+  void Update(absl::string_view str) {
+    for (char c : str) Update(c);
+  }
+
+  size_t Finish() const {
+    // FNV-1a mixes its low bits poorly, and the hash tables index by them.
+    uint64_t h = state_;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+
+ private:
+  uint64_t state_ = 0xcbf29ce484222325;
+};
+
 // True if either the arguments are equal or super_symbol identifies a
 // parent symbol of sub_symbol (e.g. "foo.bar" is a parent of
 // "foo.bar.baz", but not a parent of "foo.barbaz").
@@ -494,6 +521,28 @@ class EncodedDescriptorDatabase::DescriptorIndex {
       auto p = package(index);
       return absl::StrCat(p, p.empty() ? "" : ".", symbol(index));
     }
+
+    // Same as `AsString(index) == name`, without building the string.
+    bool FullNameEquals(const DescriptorIndex& index,
+                        absl::string_view name) const {
+      auto p = package(index);
+      auto s = symbol(index);
+      if (p.empty()) return name == s;
+      return name.size() == p.size() + 1 + s.size() &&
+             absl::StartsWith(name, p) && name[p.size()] == '.' &&
+             absl::EndsWith(name, s);
+    }
+
+    size_t Hash(const DescriptorIndex& index) const {
+      NameHasher hasher;
+      auto p = package(index);
+      if (!p.empty()) {
+        hasher.Update(p);
+        hasher.Update('.');
+      }
+      hasher.Update(symbol(index));
+      return hasher.Finish();
+    }
   };
 
   struct SymbolCompare {
@@ -562,13 +611,87 @@ class EncodedDescriptorDatabase::DescriptorIndex {
   absl::btree_set<ExtensionEntry, ExtensionCompare> by_extension_{
       ExtensionCompare{*this}};
   std::vector<ExtensionEntry> by_extension_flat_;
+
+  static size_t ExtensionHash(absl::string_view extendee, int number) {
+    NameHasher hasher;
+    hasher.Update(extendee);
+    uint32_t bits = static_cast<uint32_t>(number);
+    for (int i = 0; i < 4; ++i) {
+      hasher.Update(static_cast<char>(bits >> (8 * i)));
+    }
+    return hasher.Finish();
+  }
+
+  // Hash indices over by_symbol_flat_ and by_extension_flat_, which make
+  // FindSymbol() and FindExtension() a few hash probes instead of binary
+  // searches comparing full names.  The sets hold positions in the flat
+  // vectors, so EnsureFlat() rebuilds them whenever it merges new entries.
+  // Lookups pass a LookupKey whose hash the caller has already computed.
+  struct LookupKey {
+    size_t hash;
+    absl::string_view name;
+    int number;  // Only used for extensions.
+  };
+  struct SymbolHash {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    size_t operator()(int i) const {
+      return index.by_symbol_flat_[i].Hash(index);
+    }
+    size_t operator()(const LookupKey& key) const { return key.hash; }
+  };
+  struct SymbolEq {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    // The flat vector has no duplicate symbols.
+    bool operator()(int a, int b) const { return a == b; }
+    bool operator()(int a, const LookupKey& b) const {
+      return index.by_symbol_flat_[a].FullNameEquals(index, b.name);
+    }
+    bool operator()(const LookupKey& a, int b) const { return (*this)(b, a); }
+  };
+  absl::flat_hash_set<int, SymbolHash, SymbolEq> by_symbol_hash_{
+      0, SymbolHash{*this}, SymbolEq{*this}};
+
+  struct ExtensionHasher {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    size_t operator()(int i) const {
+      const ExtensionEntry& entry = index.by_extension_flat_[i];
+      return ExtensionHash(entry.extendee(index), entry.extension_number);
+    }
+    size_t operator()(const LookupKey& key) const { return key.hash; }
+  };
+  struct ExtensionEq {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    // The flat vector has no duplicate extensions.
+    bool operator()(int a, int b) const { return a == b; }
+    bool operator()(int a, const LookupKey& b) const {
+      const ExtensionEntry& entry = index.by_extension_flat_[a];
+      return entry.extension_number == b.number &&
+             entry.extendee(index) == b.name;
+    }
+    bool operator()(const LookupKey& a, int b) const { return (*this)(b, a); }
+  };
+  absl::flat_hash_set<int, ExtensionHasher, ExtensionEq> by_extension_hash_{
+      0, ExtensionHasher{*this}, ExtensionEq{*this}};
 };
 
 bool EncodedDescriptorDatabase::Add(const void* encoded_file_descriptor,
                                     int size) {
-  FileDescriptorProto file;
-  if (file.ParseFromArray(encoded_file_descriptor, size)) {
-    return index_->AddFile(file, std::make_pair(encoded_file_descriptor, size));
+  // This runs while generated files register themselves at static
+  // initialization, so keep the temporary off the heap: SetHeapAllocator()
+  // must still be callable from main().
+  Arena arena;
+  auto* file = Arena::CreateMessage<FileDescriptorProto>(&arena);
+  if (file->ParseFromArray(encoded_file_descriptor, size)) {
+    return index_->AddFile(*file,
+                           std::make_pair(encoded_file_descriptor, size));
   } else {
     ABSL_LOG(ERROR) << "Invalid file descriptor data passed to "
                        "EncodedDescriptorDatabase::Add().";
@@ -792,12 +915,23 @@ EncodedDescriptorDatabase::DescriptorIndex::FindSymbol(absl::string_view name) {
 std::pair<const void*, int>
 EncodedDescriptorDatabase::DescriptorIndex::FindSymbolOnlyFlat(
     absl::string_view name) const {
-  auto iter =
-      FindLastLessOrEqual(&by_symbol_flat_, name, by_symbol_.key_comp());
-
-  return iter != by_symbol_flat_.end() &&
-                 IsSubSymbol(iter->AsString(*this), name)
-             ? all_values_[iter->data_offset].value()
+  // The symbol we want is either `name` itself or one of its '.'-separated
+  // prefixes.  The by_symbol_ invariant guarantees at most one of them is in
+  // the index, so we can stop at the first hit.
+  NameHasher hasher;
+  for (size_t i = 0; i < name.size(); ++i) {
+    if (name[i] == '.') {
+      auto it = by_symbol_hash_.find(
+          LookupKey{hasher.Finish(), name.substr(0, i), 0});
+      if (it != by_symbol_hash_.end()) {
+        return all_values_[by_symbol_flat_[*it].data_offset].value();
+      }
+    }
+    hasher.Update(name[i]);
+  }
+  auto it = by_symbol_hash_.find(LookupKey{hasher.Finish(), name, 0});
+  return it != by_symbol_hash_.end()
+             ? all_values_[by_symbol_flat_[*it].data_offset].value()
              : Value();
 }
 
@@ -806,32 +940,46 @@ EncodedDescriptorDatabase::DescriptorIndex::FindExtension(
     absl::string_view containing_type, int field_number) {
   EnsureFlat();
 
-  auto it = std::lower_bound(
-      by_extension_flat_.begin(), by_extension_flat_.end(),
-      std::make_tuple(containing_type, field_number), by_extension_.key_comp());
-  return it == by_extension_flat_.end() ||
-                 it->extendee(*this) != containing_type ||
-                 it->extension_number != field_number
+  auto it = by_extension_hash_.find(
+      LookupKey{ExtensionHash(containing_type, field_number), containing_type,
+                field_number});
+  return it == by_extension_hash_.end()
              ? std::make_pair(nullptr, 0)
-             : all_values_[it->data_offset].value();
+             : all_values_[by_extension_flat_[*it].data_offset].value();
 }
 
+// Returns true if anything was merged.
 template <typename T, typename Less>
-static void MergeIntoFlat(absl::btree_set<T, Less>* s, std::vector<T>* flat) {
-  if (s->empty()) return;
+static bool MergeIntoFlat(absl::btree_set<T, Less>* s, std::vector<T>* flat) {
+  if (s->empty()) return false;
   std::vector<T> new_flat(s->size() + flat->size());
   std::merge(s->begin(), s->end(), flat->begin(), flat->end(), &new_flat[0],
              s->key_comp());
   *flat = std::move(new_flat);
   s->clear();
+  return true;
+}
+
+// Indexes every position of `flat` in `hash`.
+template <typename T, typename Set>
+static void RebuildHashIndex(const std::vector<T>& flat, Set* hash) {
+  hash->clear();
+  hash->reserve(flat.size());
+  for (int i = 0; i < static_cast<int>(flat.size()); ++i) {
+    hash->insert(i);
+  }
 }
 
 void EncodedDescriptorDatabase::DescriptorIndex::EnsureFlat() {
   all_values_.shrink_to_fit();
   // Merge each of the sets into their flat counterpart.
   MergeIntoFlat(&by_name_, &by_name_flat_);
-  MergeIntoFlat(&by_symbol_, &by_symbol_flat_);
-  MergeIntoFlat(&by_extension_, &by_extension_flat_);
+  if (MergeIntoFlat(&by_symbol_, &by_symbol_flat_)) {
+    RebuildHashIndex(by_symbol_flat_, &by_symbol_hash_);
+  }
+  if (MergeIntoFlat(&by_extension_, &by_extension_flat_)) {
+    RebuildHashIndex(by_extension_flat_, &by_extension_hash_);
+  }
 }
 
 bool EncodedDescriptorDatabase::DescriptorIndex::FindAllExtensionNumbers(
@@ -966,10 +1114,103 @@ MergedDescriptorDatabase::MergedDescriptorDatabase(
     : sources_(sources) {}
 MergedDescriptorDatabase::~MergedDescriptorDatabase() {}
 
+void MergedDescriptorDatabase::EnableMissCache(int max_misses_per_source) {
+  ABSL_CHECK_GT(max_misses_per_source, 0);
+  absl::MutexLock lock(&misses_mutex_);
+  misses_.clear();
+  misses_.resize(sources_.size());
+  max_misses_per_source_.store(max_misses_per_source,
+                               std::memory_order_release);
+}
+
+void MergedDescriptorDatabase::ClearMissCache() {
+  absl::MutexLock lock(&misses_mutex_);
+  for (SourceMisses& misses : misses_) {
+    misses = SourceMisses();
+  }
+  ++misses_generation_;
+}
+
+namespace {
+
+template <typename Key>
+void RecordMiss(absl::flat_hash_set<Key>* misses, Key key, int max_misses) {
+  if (misses->size() >= static_cast<size_t>(max_misses)) misses->clear();
+  misses->insert(std::move(key));
+}
+
+}  // namespace
+
+bool MergedDescriptorDatabase::FindFileByNameInSource(
+    size_t source, const std::string& filename, FileDescriptorProto* output) {
+  if (max_misses_per_source_.load(std::memory_order_acquire) == 0) {
+    return sources_[source]->FindFileByName(filename, output);
+  }
+  uint64_t generation;
+  {
+    absl::MutexLock lock(&misses_mutex_);
+    if (misses_[source].files.contains(filename)) return false;
+    generation = misses_generation_;
+  }
+  if (sources_[source]->FindFileByName(filename, output)) return true;
+  absl::MutexLock lock(&misses_mutex_);
+  if (generation != misses_generation_) return false;
+  RecordMiss(&misses_[source].files, filename,
+             max_misses_per_source_.load(std::memory_order_relaxed));
+  return false;
+}
+
+bool MergedDescriptorDatabase::FindFileContainingSymbolInSource(
+    size_t source, const std::string& symbol_name,
+    FileDescriptorProto* output) {
+  if (max_misses_per_source_.load(std::memory_order_acquire) == 0) {
+    return sources_[source]->FindFileContainingSymbol(symbol_name, output);
+  }
+  uint64_t generation;
+  {
+    absl::MutexLock lock(&misses_mutex_);
+    if (misses_[source].symbols.contains(symbol_name)) return false;
+    generation = misses_generation_;
+  }
+  if (sources_[source]->FindFileContainingSymbol(symbol_name, output)) {
+    return true;
+  }
+  absl::MutexLock lock(&misses_mutex_);
+  if (generation != misses_generation_) return false;
+  RecordMiss(&misses_[source].symbols, symbol_name,
+             max_misses_per_source_.load(std::memory_order_relaxed));
+  return false;
+}
+
+bool MergedDescriptorDatabase::FindFileContainingExtensionInSource(
+    size_t source, const std::string& containing_type, int field_number,
+    FileDescriptorProto* output) {
+  if (max_misses_per_source_.load(std::memory_order_acquire) == 0) {
+    return sources_[source]->FindFileContainingExtension(
+        containing_type, field_number, output);
+  }
+  std::pair<std::string, int> key(containing_type, field_number);
+  uint64_t generation;
+  {
+    absl::MutexLock lock(&misses_mutex_);
+    if (misses_[source].extensions.contains(key)) return false;
+    generation = misses_generation_;
+  }
+  if (sources_[source]->FindFileContainingExtension(containing_type,
+                                                    field_number, output)) {
+    return true;
+  }
+  absl::MutexLock lock(&misses_mutex_);
+  if (generation != misses_generation_) return false;
+  RecordMiss(&misses_[source].extensions, std::move(key),
+             max_misses_per_source_.load(std::memory_order_relaxed));
+  return false;
+}
+
 bool MergedDescriptorDatabase::FindFileByName(const std::string& filename,
                                               FileDescriptorProto* output) {
-  for (DescriptorDatabase* source : sources_) {
-    if (source->FindFileByName(filename, output)) {
+  for (size_t i = 0; i < sources_.size(); i++) {
+    if (FindFileByNameInSource(i, filename, output)) {
       return true;
     }
   }
@@ -979,14 +1220,14 @@ bool MergedDescriptorDatabase::FindFileByName(const std::string& filename,
 bool MergedDescriptorDatabase::FindFileContainingSymbol(
     const std::string& symbol_name, FileDescriptorProto* output) {
   for (size_t i = 0; i < sources_.size(); i++) {
-    if (sources_[i]->FindFileContainingSymbol(symbol_name, output)) {
+    if (FindFileContainingSymbolInSource(i, symbol_name, output)) {
       // The symbol was found in source i.  However, if one of the previous
       // sources defines a file with the same name (which presumably doesn't
       // contain the symbol, since it wasn't found in that source), then we
       // must hide it from the caller.
       FileDescriptorProto temp;
       for (size_t j = 0; j < i; j++) {
-        if (sources_[j]->FindFileByName(output->name(), &temp)) {
+        if (FindFileByNameInSource(j, output->name(), &temp)) {
           // Found conflicting file in a previous source.
           return false;
         }
@@ -1001,15 +1242,15 @@ bool MergedDescriptorDatabase::FindFileContainingExtension(
     const std::string& containing_type, int field_number,
     FileDescriptorProto* output) {
   for (size_t i = 0; i < sources_.size(); i++) {
-    if (sources_[i]->FindFileContainingExtension(containing_type, field_number,
-                                                 output)) {
+    if (FindFileContainingExtensionInSource(i, containing_type, field_number,
+                                            output)) {
       // The symbol was found in source i.  However, if one of the previous
       // sources defines a file with the same name (which presumably doesn't
       // contain the symbol, since it wasn't found in that source), then we
       // must hide it from the caller.
       FileDescriptorProto temp;
       for (size_t j = 0; j < i; j++) {
-        if (sources_[j]->FindFileByName(output->name(), &temp)) {
+        if (FindFileByNameInSource(j, output->name(), &temp)) {
           // Found conflicting file in a previous source.
           return false;
         }
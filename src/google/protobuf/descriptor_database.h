@@ -37,11 +37,16 @@
 #ifndef GOOGLE_PROTOBUF_DESCRIPTOR_DATABASE_H__
 #define GOOGLE_PROTOBUF_DESCRIPTOR_DATABASE_H__
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/port.h"
 
@@ -391,8 +396,48 @@ class PROTOBUF_EXPORT MergedDescriptorDatabase : public DescriptorDatabase {
   // DescriptorDatabase returns true.
   bool FindAllFileNames(std::vector<std::string>* output) override;
 
+  // Remembers, for each source, the files, symbols and extensions it could
+  // not find, so that repeated misses (common while scanning for extensions
+  // or resolving Any type URLs) don't query every source again.  At most
+  // max_misses_per_source misses of each kind are kept per source; a cache
+  // that fills up is cleared and starts over.  Must be called before the
+  // database is used.  If a source can gain files afterwards, call
+  // ClearMissCache() after it does.
+  void EnableMissCache(int max_misses_per_source = 4096);
+
+  // Forgets all misses remembered by the cache enabled with EnableMissCache().
+  void ClearMissCache();
+
  private:
+  // Look up in sources_[source], consulting and filling the miss cache if it
+  // is enabled.
+  bool FindFileByNameInSource(size_t source, const std::string& filename,
+                              FileDescriptorProto* output);
+  bool FindFileContainingSymbolInSource(size_t source,
+                                        const std::string& symbol_name,
+                                        FileDescriptorProto* output);
+  bool FindFileContainingExtensionInSource(size_t source,
+                                           const std::string& containing_type,
+                                           int field_number,
+                                           FileDescriptorProto* output);
+
   std::vector<DescriptorDatabase*> sources_;
+
+  struct SourceMisses {
+    absl::flat_hash_set<std::string> files;
+    absl::flat_hash_set<std::string> symbols;
+    absl::flat_hash_set<std::pair<std::string, int>> extensions;
+  };
+  // Zero while the miss cache is disabled.  Read without the lock on every
+  // lookup, so it is published only after misses_ has been sized.
+  std::atomic<int> max_misses_per_source_{0};
+  absl::Mutex misses_mutex_;
+  // One entry per source.
+  std::vector<SourceMisses> misses_ ABSL_GUARDED_BY(misses_mutex_);
+  // Bumped by ClearMissCache().  A lookup records its miss only if no clear
+  // happened while it queried the source, as the source may have gained the
+  // file in between.
+  uint64_t misses_generation_ ABSL_GUARDED_BY(misses_mutex_) = 0;
 };
 
 }  // namespace protobuf
@@ -37,7 +37,10 @@
 #include "google/protobuf/descriptor_database.h"
 
 #include <algorithm>
+#include <functional>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
@@ -381,6 +384,52 @@ TEST_P(DescriptorDatabaseTest, FindFileContainingExtension) {
   }
 }
 
+TEST_P(DescriptorDatabaseTest, FindAfterAddingMoreFiles) {
+  // Lookups in between adds must still see everything added so far.
+  AddToDatabase(
+      "name: \"foo.proto\" "
+      "package: \"corge.grault\" "
+      "message_type { "
+      "  name: \"Foo\" "
+      "  extension_range { start: 1 end: 1000 } "
+      "}");
+
+  {
+    FileDescriptorProto file;
+    EXPECT_TRUE(
+        database_->FindFileContainingSymbol("corge.grault.Foo.bar", &file));
+    EXPECT_EQ("foo.proto", file.name());
+    EXPECT_FALSE(database_->FindFileContainingSymbol("corge.Bar", &file));
+    EXPECT_FALSE(
+        database_->FindFileContainingExtension("corge.grault.Foo", 5, &file));
+  }
+
+  AddToDatabase(
+      "name: \"bar.proto\" "
+      "package: \"corge\" "
+      "dependency: \"foo.proto\" "
+      "message_type { name: \"Bar\" } "
+      "extension { name:\"qux\" extendee: \".corge.grault.Foo\" "
+      "            number:5 }");
+
+  {
+    FileDescriptorProto file;
+    EXPECT_TRUE(database_->FindFileContainingSymbol("corge.Bar", &file));
+    EXPECT_EQ("bar.proto", file.name());
+    EXPECT_TRUE(database_->FindFileContainingSymbol("corge.qux", &file));
+    EXPECT_EQ("bar.proto", file.name());
+    EXPECT_TRUE(database_->FindFileContainingSymbol("corge.grault.Foo", &file));
+    EXPECT_EQ("foo.proto", file.name());
+    EXPECT_TRUE(
+        database_->FindFileContainingExtension("corge.grault.Foo", 5, &file));
+    EXPECT_EQ("bar.proto", file.name());
+
+    // Packages are not symbols.
+    EXPECT_FALSE(database_->FindFileContainingSymbol("corge", &file));
+    EXPECT_FALSE(database_->FindFileContainingSymbol("corge.grault", &file));
+  }
+}
+
 TEST_P(DescriptorDatabaseTest, FindAllExtensionNumbers) {
   AddToDatabase(
       "name: \"foo.proto\" "
@@ -820,6 +869,139 @@ TEST_F(MergedDescriptorDatabaseTest, FindAllExtensionNumbers) {
   }
 }
 
+// Forwards to another DescriptorDatabase, counting the lookups.
+class CountingDescriptorDatabase : public DescriptorDatabase {
+ public:
+  explicit CountingDescriptorDatabase(DescriptorDatabase* wrapped)
+      : wrapped_(wrapped) {}
+
+  bool FindFileByName(const std::string& filename,
+                      FileDescriptorProto* output) override {
+    ++lookups_;
+    return wrapped_->FindFileByName(filename, output);
+  }
+  bool FindFileContainingSymbol(const std::string& symbol_name,
+                                FileDescriptorProto* output) override {
+    ++lookups_;
+    return wrapped_->FindFileContainingSymbol(symbol_name, output);
+  }
+  bool FindFileContainingExtension(const std::string& containing_type,
+                                   int field_number,
+                                   FileDescriptorProto* output) override {
+    ++lookups_;
+    return wrapped_->FindFileContainingExtension(containing_type,
+                                                 field_number, output);
+  }
+
+  int lookups() const { return lookups_; }
+
+ private:
+  DescriptorDatabase* wrapped_;
+  int lookups_ = 0;
+};
+
+TEST_F(MergedDescriptorDatabaseTest, MissCacheSkipsKnownMisses) {
+  CountingDescriptorDatabase counting1(&database1_);
+  MergedDescriptorDatabase merged(&counting1, &database2_);
+  merged.EnableMissCache();
+
+  FileDescriptorProto file;
+  EXPECT_TRUE(merged.FindFileContainingSymbol("Bar", &file));
+  EXPECT_EQ("bar.proto", file.name());
+  EXPECT_TRUE(merged.FindFileContainingExtension("Bar", 5, &file));
+  EXPECT_EQ("bar.proto", file.name());
+  EXPECT_FALSE(merged.FindFileByName("no_such_file.proto", &file));
+  int lookups = counting1.lookups();
+
+  // database1_ is not asked again about anything it didn't have.
+  EXPECT_TRUE(merged.FindFileContainingSymbol("Bar", &file));
+  EXPECT_EQ("bar.proto", file.name());
+  EXPECT_TRUE(merged.FindFileContainingExtension("Bar", 5, &file));
+  EXPECT_EQ("bar.proto", file.name());
+  EXPECT_FALSE(merged.FindFileByName("no_such_file.proto", &file));
+  EXPECT_EQ(lookups, counting1.lookups());
+
+  // Hits are not cached.
+  EXPECT_TRUE(merged.FindFileByName("foo.proto", &file));
+  EXPECT_EQ(lookups + 1, counting1.lookups());
+}
+
+TEST_F(MergedDescriptorDatabaseTest, ClearMissCache) {
+  MergedDescriptorDatabase merged(&database1_, &database2_);
+  merged.EnableMissCache();
+
+  FileDescriptorProto file;
+  EXPECT_FALSE(merged.FindFileContainingSymbol("Qux", &file));
+
+  AddToDatabase(&database1_,
+                "name: \"qux.proto\" "
+                "message_type { name:\"Qux\" } ");
+  EXPECT_FALSE(merged.FindFileContainingSymbol("Qux", &file));
+
+  merged.ClearMissCache();
+  EXPECT_TRUE(merged.FindFileContainingSymbol("Qux", &file));
+  EXPECT_EQ("qux.proto", file.name());
+}
+
+// Runs a callback in the middle of each lookup, after the wrapped database
+// has answered, as a concurrent caller could.
+class InterleavingDescriptorDatabase : public CountingDescriptorDatabase {
+ public:
+  InterleavingDescriptorDatabase(DescriptorDatabase* wrapped,
+                                 std::function<void()> callback)
+      : CountingDescriptorDatabase(wrapped), callback_(std::move(callback)) {}
+
+  bool FindFileByName(const std::string& filename,
+                      FileDescriptorProto* output) override {
+    bool found = CountingDescriptorDatabase::FindFileByName(filename, output);
+    callback_();
+    return found;
+  }
+
+ private:
+  std::function<void()> callback_;
+};
+
+TEST_F(MergedDescriptorDatabaseTest, ClearMissCacheDuringLookup) {
+  MergedDescriptorDatabase* merged_ptr = nullptr;
+  bool added = false;
+  InterleavingDescriptorDatabase source1(&database1_, [&] {
+    if (added) return;
+    added = true;
+    // The file shows up, and the cache is cleared, while the lookup that
+    // missed it is still in flight.
+    AddToDatabase(&database1_, "name: \"qux.proto\"");
+    merged_ptr->ClearMissCache();
+  });
+  MergedDescriptorDatabase merged(&source1, &database2_);
+  merged_ptr = &merged;
+  merged.EnableMissCache();
+
+  FileDescriptorProto file;
+  EXPECT_FALSE(merged.FindFileByName("qux.proto", &file));
+  // The stale miss was not recorded.
+  int lookups = source1.lookups();
+  EXPECT_TRUE(merged.FindFileByName("qux.proto", &file));
+  EXPECT_EQ(lookups + 1, source1.lookups());
+}
+
+TEST_F(MergedDescriptorDatabaseTest, MissCacheIsBounded) {
+  CountingDescriptorDatabase counting1(&database1_);
+  MergedDescriptorDatabase merged(&counting1, &database2_);
+  merged.EnableMissCache(1);
+
+  FileDescriptorProto file;
+  EXPECT_FALSE(merged.FindFileByName("a.proto", &file));
+  EXPECT_FALSE(merged.FindFileByName("b.proto", &file));
+  int lookups = counting1.lookups();
+
+  // Remembering b.proto pushed a.proto out of the cache.
+  EXPECT_FALSE(merged.FindFileByName("b.proto", &file));
+  EXPECT_EQ(lookups, counting1.lookups());
+  EXPECT_FALSE(merged.FindFileByName("a.proto", &file));
+  EXPECT_EQ(lookups + 1, counting1.lookups());
+}
+
 TEST_F(MergedDescriptorDatabaseTest, FindAllFileNames) {
   std::vector<std::string> files;
   EXPECT_TRUE(forward_merged_.FindAllFileNames(&files));
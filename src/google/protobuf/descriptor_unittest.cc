@@ -7243,6 +7243,10 @@ class DatabaseBackedPoolTest : public testing::Test {
       return wrapped_db_->FindFileContainingExtension(containing_type,
                                                       field_number, output);
     }
+    bool FindAllFileNames(std::vector<std::string>* output) override {
+      ++call_count_;
+      return wrapped_db_->FindAllFileNames(output);
+    }
   };
 
   // A DescriptorDatabase which falsely always returns foo.proto when searching
@@ -7504,6 +7508,57 @@ TEST_F(DatabaseBackedPoolTest, DoesntRetryDbUnnecessarily) {
   EXPECT_EQ(0, call_counter.call_count_);
 }
 
+TEST_F(DatabaseBackedPoolTest, BuildAllFilesFromDatabase) {
+  SimpleDescriptorDatabase database;
+  AddToDatabase(&database,
+                "name: 'foo.proto' "
+                "message_type { name:'Foo' } "
+                "service { name:'TestService' } ");
+  AddToDatabase(&database,
+                "name: 'bar.proto' "
+                "dependency: 'foo.proto' "
+                "message_type { "
+                "  name:'Bar' "
+                "  field { name:'foo' number:1 label:LABEL_OPTIONAL "
+                "          type_name:'Foo' } "
+                "} ");
+  CallCountingDatabase call_counter(&database);
+  DescriptorPool pool(&call_counter);
+
+  EXPECT_TRUE(pool.BuildAllFilesFromDatabase());
+  EXPECT_NE(0, call_counter.call_count_);
+  call_counter.Clear();
+
+  // Everything is already built, so nothing falls back to the database.
+  EXPECT_TRUE(pool.FindFileByName("foo.proto") != nullptr);
+  EXPECT_TRUE(pool.FindMessageTypeByName("Bar") != nullptr);
+  EXPECT_TRUE(pool.FindServiceByName("TestService") != nullptr);
+  EXPECT_EQ(0, call_counter.call_count_);
+}
+
+TEST_F(DatabaseBackedPoolTest, BuildAllFilesFromDatabaseWithBadFile) {
+  CallCountingDatabase call_counter(&database_);
+  DescriptorPool pool(&call_counter);
+
+  // baz.proto has an undeclared dependency, but the other files still build.
+  EXPECT_FALSE(pool.BuildAllFilesFromDatabase());
+  call_counter.Clear();
+
+  EXPECT_TRUE(pool.FindFileByName("bar.proto") != nullptr);
+  EXPECT_TRUE(pool.FindMessageTypeByName("Foo") != nullptr);
+  EXPECT_EQ(0, call_counter.call_count_);
+}
+
+TEST_F(DatabaseBackedPoolTest, BuildAllFilesFromDatabaseWithoutFileList) {
+  // ErrorDescriptorDatabase can't list its files.
+  ErrorDescriptorDatabase error_database;
+  DescriptorPool pool(&error_database);
+  EXPECT_FALSE(pool.BuildAllFilesFromDatabase());
+
+  DescriptorPool pool_without_database;
+  EXPECT_FALSE(pool_without_database.BuildAllFilesFromDatabase());
+}
+
 TEST_F(DatabaseBackedPoolTest, DoesntReloadFilesUncesessarily) {
   // If FindFileContainingSymbol() or FindFileContainingExtension() return a
   // file that is already in the DescriptorPool, it should not attempt to
@@ -236,12 +236,14 @@ class DynamicMessage : public Message {
   static void operator delete(DynamicMessage* msg, std::destroying_delete_t);
 #else
   // We actually allocate more memory than sizeof(*this) when this
-  // class's memory is allocated via the global operator new. Thus, we need to
-  // manually call the global operator delete. Calling the destructor is taken
-  // care of for us. This makes DynamicMessage compatible with -fsized-delete.
-  // It doesn't work for MSVC though.
+  // class's memory is allocated via internal::AllocateHeap(). Thus, we need to
+  // free it without a size. Calling the destructor is taken care of for us.
+  // This makes DynamicMessage compatible with -fsized-delete. It doesn't work
+  // for MSVC though.
 #ifndef _MSC_VER
-  static void operator delete(void* ptr) { ::operator delete(ptr); }
+  static void operator delete(void* ptr) {
+    internal::DeallocateHeapUnsized(ptr);
+  }
 #endif  // !_MSC_VER
 #endif
 
@@ -487,7 +489,7 @@ void DynamicMessage::operator delete(DynamicMessage* msg,
                                      std::destroying_delete_t) {
   const size_t size = msg->type_info_->size;
   msg->~DynamicMessage();
-  ::operator delete(msg, size);
+  internal::DeallocateHeap(msg, size);
 }
 #endif
 
@@ -617,7 +619,7 @@ Message* DynamicMessage::New(Arena* arena) const {
     memset(new_base, 0, type_info_->size);
     return new (new_base) DynamicMessage(type_info_, arena);
   } else {
-    void* new_base = operator new(type_info_->size);
+    void* new_base = internal::AllocateHeap(type_info_->size);
     memset(new_base, 0, type_info_->size);
     return new (new_base) DynamicMessage(type_info_);
   }
@@ -791,7 +793,7 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
   }
 
   // Allocate the prototype fields.
-  void* base = operator new(size);
+  void* base = internal::AllocateHeap(size);
   memset(base, 0, size);
 
   // We have already locked the factory so we should not lock in the constructor
@@ -46,6 +46,7 @@
 
 #include "google/protobuf/stubs/common.h"
 #include "absl/container/btree_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/port.h"
@@ -217,6 +218,12 @@ class PROTOBUF_EXPORT ExtensionSet {
   void AppendToList(const Descriptor* extendee, const DescriptorPool* pool,
                     std::vector<const FieldDescriptor*>* output) const;
 
+  // Like AppendToList(), but calls `func` for each present field instead of
+  // collecting them.
+  void ForEachPresent(
+      const Descriptor* extendee, const DescriptorPool* pool,
+      absl::FunctionRef<void(const FieldDescriptor*)> func) const;
+
   // =================================================================
   // Accessors
   //
@@ -588,6 +595,8 @@ class PROTOBUF_EXPORT ExtensionSet {
   };
   // Give access to function defined below to see LazyMessageExtension.
   friend LazyMessageExtension* MaybeCreateLazyExtension(Arena* arena);
+  // Defined in extension_set_heavy.cc.
+  class LazyMessageSetItem;
   struct Extension {
     // The order of these fields packs Extension into 24 bytes when using 8
     // byte alignment. Consider this when adding or removing fields here.
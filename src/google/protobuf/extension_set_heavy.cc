@@ -35,6 +35,8 @@
 // Contains methods defined in extension_set.h which cannot be part of the
 // lite library because they use descriptors or reflection.
 
+#include <atomic>
+#include <string>
 #include <vector>
 
 #include "google/protobuf/arena.h"
@@ -47,6 +49,7 @@
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/parse_context.h"
 #include "google/protobuf/port.h"
+#include "google/protobuf/reflection_ops.h"
 #include "google/protobuf/repeated_field.h"
 #include "google/protobuf/unknown_field_set.h"
 #include "google/protobuf/wire_format_lite.h"
@@ -80,7 +83,15 @@ class DescriptorPoolExtensionFinder {
 void ExtensionSet::AppendToList(
     const Descriptor* extendee, const DescriptorPool* pool,
     std::vector<const FieldDescriptor*>* output) const {
-  ForEach([extendee, pool, &output](int number, const Extension& ext) {
+  ForEachPresent(extendee, pool, [output](const FieldDescriptor* field) {
+    output->push_back(field);
+  });
+}
+
+void ExtensionSet::ForEachPresent(
+    const Descriptor* extendee, const DescriptorPool* pool,
+    absl::FunctionRef<void(const FieldDescriptor*)> func) const {
+  ForEach([extendee, pool, func](int number, const Extension& ext) {
     bool has = false;
     if (ext.is_repeated) {
       has = ext.GetSize() > 0;
@@ -95,9 +106,9 @@ void ExtensionSet::AppendToList(
       //   AppendToList() is called.
 
       if (ext.descriptor == nullptr) {
-        output->push_back(pool->FindExtensionByNumber(extendee, number));
+        func(pool->FindExtensionByNumber(extendee, number));
       } else {
-        output->push_back(ext.descriptor);
+        func(ext.descriptor);
       }
     }
   });
@@ -341,10 +352,226 @@ const char* ExtensionSet::ParseField(uint64_t tag, const char* ptr,
       number, was_packed_on_wire, extension, metadata, ptr, ctx);
 }
 
+// A MessageSet item kept in serialized form until it is first accessed. The
+// bytes are checked to be well-formed wire format when they are parsed, but
+// the message itself is only built by the first call that needs it.
+//
+// `bytes_` stays the serialized form of the item until the message is handed
+// out for mutation, so an item that is only read is re-serialized by copying
+// the bytes. Const access may come from several threads at once, so the
+// parsed message is published with a compare-and-swap.
+class ExtensionSet::LazyMessageSetItem final : public LazyMessageExtension {
+ public:
+  LazyMessageSetItem(const MessageLite* prototype, Arena* arena)
+      : prototype_(prototype), arena_(arena) {}
+  ~LazyMessageSetItem() override {
+    if (arena_ == nullptr) delete message_.load(std::memory_order_relaxed);
+  }
+
+  LazyMessageExtension* New(Arena* arena) const override {
+    return Arena::Create<LazyMessageSetItem>(arena, prototype_, arena);
+  }
+
+  const MessageLite& GetMessage(const MessageLite& /* prototype */,
+                                Arena* /* arena */) const override {
+    MessageLite* message = message_.load(std::memory_order_acquire);
+    if (message != nullptr) return *message;
+    MessageLite* parsed = prototype_->New(arena_);
+    // The bytes were checked when they were read, so this can only fail on
+    // semantic errors such as invalid UTF-8, which we tolerate like the
+    // parser does for partial messages.
+    parsed->ParsePartialFromString(bytes_);
+    if (message_.compare_exchange_strong(message, parsed,
+                                         std::memory_order_acq_rel)) {
+      return *parsed;
+    }
+    if (arena_ == nullptr) delete parsed;
+    return *message;
+  }
+
+  MessageLite* MutableMessage(const MessageLite& prototype,
+                              Arena* arena) override {
+    MessageLite* message =
+        const_cast<MessageLite*>(&GetMessage(prototype, arena));
+    mutated_ = true;
+    bytes_.clear();
+    return message;
+  }
+
+  void SetAllocatedMessage(MessageLite* message, Arena* arena) override {
+    Arena* message_arena = message->GetOwningArena();
+    if (message_arena != arena && message_arena == nullptr) {
+      arena->Own(message);
+    } else if (message_arena != arena) {
+      MessageLite* copy = message->New(arena);
+      copy->CheckTypeAndMergeFrom(*message);
+      message = copy;
+    }
+    UnsafeArenaSetAllocatedMessage(message, arena);
+  }
+
+  void UnsafeArenaSetAllocatedMessage(MessageLite* message,
+                                      Arena* arena) override {
+    if (arena == nullptr) delete message_.load(std::memory_order_relaxed);
+    message_.store(message, std::memory_order_relaxed);
+    mutated_ = true;
+    bytes_.clear();
+  }
+
+  MessageLite* ReleaseMessage(const MessageLite& prototype,
+                              Arena* arena) override {
+    MessageLite* message = UnsafeArenaReleaseMessage(prototype, arena);
+    if (arena == nullptr) return message;
+    // ReleaseMessage() always returns a heap-allocated message.
+    MessageLite* copy = message->New();
+    copy->CheckTypeAndMergeFrom(*message);
+    return copy;
+  }
+
+  MessageLite* UnsafeArenaReleaseMessage(const MessageLite& prototype,
+                                         Arena* arena) override {
+    MessageLite* message = MutableMessage(prototype, arena);
+    message_.store(nullptr, std::memory_order_relaxed);
+    mutated_ = false;
+    return message;
+  }
+
+  bool IsInitialized(const MessageLite* prototype,
+                     Arena* arena) const override {
+    // Most item types have no required fields anywhere, so there is no need
+    // to parse them.
+    if (!ReflectionOps::MayBeUninitialized(
+            *DownCast<const Message*>(prototype_))) {
+      return true;
+    }
+    return GetMessage(*prototype, arena).IsInitialized();
+  }
+
+  bool IsEagerSerializeSafe(const MessageLite* /* prototype */,
+                            Arena* /* arena */) const override {
+    return true;
+  }
+
+  size_t ByteSizeLong() const override {
+    if (!mutated_) return bytes_.size();
+    return message_.load(std::memory_order_relaxed)->ByteSizeLong();
+  }
+
+  size_t SpaceUsedLong() const override {
+    size_t total_size =
+        sizeof(*this) + StringSpaceUsedExcludingSelfLong(bytes_);
+    if (const MessageLite* message = message_.load(std::memory_order_acquire)) {
+      total_size += DownCast<const Message*>(message)->SpaceUsedLong();
+    }
+    return total_size;
+  }
+
+  void MergeFrom(const MessageLite* prototype,
+                 const LazyMessageExtension& other, Arena* arena) override {
+    const auto& other_item = static_cast<const LazyMessageSetItem&>(other);
+    if (!IsParsed() && !other_item.mutated_) {
+      // Concatenating serialized messages merges them.
+      bytes_.append(other_item.bytes_);
+      return;
+    }
+    MutableMessage(*prototype, arena)
+        ->CheckTypeAndMergeFrom(other_item.GetMessage(*prototype, arena));
+  }
+
+  void MergeFromMessage(const MessageLite& msg, Arena* arena) override {
+    MutableMessage(msg, arena)->CheckTypeAndMergeFrom(msg);
+  }
+
+  void Clear() override {
+    bytes_.clear();
+    if (MessageLite* message = message_.load(std::memory_order_relaxed)) {
+      message->Clear();
+      mutated_ = true;
+    }
+  }
+
+  const char* _InternalParse(const MessageLite& /* prototype */,
+                             Arena* /* arena */,
+                             LazyVerifyOption /* option */, const char* ptr,
+                             ParseContext* ctx) override {
+    if (IsParsed()) {
+      // References to the parsed message may have been handed out, so merge
+      // into it rather than replacing it.
+      return ctx->ParseMessage(MutableMessage(*prototype_, arena_), ptr);
+    }
+    int size = ReadSize(&ptr);
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+    size_t old_size = bytes_.size();
+    ptr = ctx->AppendString(ptr, size, &bytes_);
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+    io::CodedInputStream input(
+        reinterpret_cast<const uint8_t*>(bytes_.data() + old_size), size);
+    if (!WireFormatLite::SkipMessage(&input) ||
+        input.CurrentPosition() != size) {
+      return nullptr;
+    }
+    return ptr;
+  }
+
+  uint8_t* WriteMessageToArray(const MessageLite* /* prototype */, int number,
+                               uint8_t* target,
+                               io::EpsCopyOutputStream* stream) const override {
+    if (!mutated_) return stream->WriteString(number, bytes_, target);
+    const MessageLite* message = message_.load(std::memory_order_relaxed);
+    return WireFormatLite::InternalWriteMessage(
+        number, *message, message->GetCachedSize(), target, stream);
+  }
+
+ private:
+  // Whether the message was built, by an accessor or a mutator. Once it is,
+  // it has to be kept, since references to it may have been handed out.
+  bool IsParsed() const {
+    return message_.load(std::memory_order_relaxed) != nullptr;
+  }
+
+  const MessageLite* prototype_;
+  Arena* arena_;
+  // Valid unless mutated_.
+  std::string bytes_;
+  // Parsed from bytes_ on first access, or set by a mutator.
+  mutable std::atomic<MessageLite*> message_{nullptr};
+  // Whether the message was handed out for mutation, which makes it the
+  // authoritative value instead of bytes_.
+  bool mutated_ = false;
+};
+
 const char* ExtensionSet::ParseFieldMaybeLazily(
     uint64_t tag, const char* ptr, const Message* extendee,
     internal::InternalMetadata* metadata, internal::ParseContext* ctx) {
-  return ParseField(tag, ptr, extendee, metadata, ctx);
+  // Lazy items find their prototype again through the generated registry when
+  // they are serialized, so items resolved through a pool are parsed eagerly.
+  if (!ctx->data().lazy_message_set_items || ctx->data().pool != nullptr) {
+    return ParseField(tag, ptr, extendee, metadata, ctx);
+  }
+  int number = tag >> 3;
+  bool was_packed_on_wire;
+  ExtensionInfo info;
+  if (!FindExtension(WireFormatLite::WIRETYPE_LENGTH_DELIMITED, number,
+                     extendee, ctx, &info, &was_packed_on_wire) ||
+      info.type != WireFormatLite::TYPE_MESSAGE || info.is_repeated) {
+    return ParseField(tag, ptr, extendee, metadata, ctx);
+  }
+
+  Extension* extension;
+  if (MaybeNewExtension(number, info.descriptor, &extension)) {
+    extension->type = info.type;
+    extension->is_repeated = false;
+    extension->is_packed = false;
+    extension->is_lazy = true;
+    extension->lazymessage_value = Arena::Create<LazyMessageSetItem>(
+        arena_, info.message_info.prototype, arena_);
+  }
+  extension->is_cleared = false;
+  if (!extension->is_lazy) {
+    return ctx->ParseMessage(extension->message_value, ptr);
+  }
+  return extension->lazymessage_value->_InternalParse(
+      *info.message_info.prototype, arena_, LazyVerifyOption{}, ptr, ctx);
 }
 
 const char* ExtensionSet::ParseMessageSetItem(
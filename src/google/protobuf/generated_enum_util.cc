@@ -31,6 +31,7 @@
 #include "google/protobuf/generated_enum_util.h"
 
 #include <algorithm>
+#include <cstdint>
 
 #include "google/protobuf/generated_message_util.h"
 
@@ -69,6 +70,16 @@ bool LookUpEnumValue(const EnumEntry* enums, size_t size,
 
 int LookUpEnumName(const EnumEntry* enums, const int* sorted_indices,
                    size_t size, int value) {
+  if (size == 0) return -1;
+  // Most enums are numbered without gaps, in which case the position in
+  // sorted_indices follows directly from the value.
+  const int64_t offset =
+      static_cast<int64_t>(value) - enums[sorted_indices[0]].value;
+  if (offset >= 0 && static_cast<uint64_t>(offset) < size &&
+      enums[sorted_indices[offset]].value == value) {
+    return static_cast<int>(offset);
+  }
+
   auto comparator = [enums, value](int a, int b) {
     return GetValue(enums, a, value) < GetValue(enums, b, value);
   };
@@ -39,6 +39,7 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <vector>
 
 #include "absl/base/casts.h"
 #include "absl/container/flat_hash_map.h"
@@ -330,7 +331,130 @@ bool Reflection::IsInlined(const FieldDescriptor* field) const {
   return schema_.IsFieldInlined(field);
 }
 
+std::vector<Reflection::SpaceUsedField> Reflection::CreateSpaceUsedFields()
+    const {
+  std::vector<SpaceUsedField> fields;
+  for (int i = 0; i <= last_non_weak_field_index_; i++) {
+    const FieldDescriptor* field = descriptor_->field(i);
+    SpaceUsedField::Kind kind;
+    if (field->is_repeated()) {
+      switch (field->cpp_type()) {
+#define HANDLE_TYPE(UPPERCASE, KIND)         \
+  case FieldDescriptor::CPPTYPE_##UPPERCASE: \
+    kind = SpaceUsedField::KIND;             \
+    break
+
+        HANDLE_TYPE(INT32, kRepeatedInt32);
+        HANDLE_TYPE(INT64, kRepeatedInt64);
+        HANDLE_TYPE(UINT32, kRepeatedUInt32);
+        HANDLE_TYPE(UINT64, kRepeatedUInt64);
+        HANDLE_TYPE(DOUBLE, kRepeatedDouble);
+        HANDLE_TYPE(FLOAT, kRepeatedFloat);
+        HANDLE_TYPE(BOOL, kRepeatedBool);
+        HANDLE_TYPE(ENUM, kRepeatedEnum);
+#undef HANDLE_TYPE
+        case FieldDescriptor::CPPTYPE_STRING:
+          // TODO(kenton):  Support other string reps.
+          kind = SpaceUsedField::kRepeatedString;
+          break;
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+          kind = IsMapFieldInApi(field) ? SpaceUsedField::kMap
+                                        : SpaceUsedField::kRepeatedMessage;
+          break;
+      }
+    } else {
+      switch (field->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_STRING:
+          // TODO(kenton):  Support other string reps.
+          kind = IsInlined(field) ? SpaceUsedField::kInlinedString
+                                  : SpaceUsedField::kString;
+          break;
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+          kind = SpaceUsedField::kMessage;
+          break;
+        default:
+          // Field is inline, so it is already counted in the object size.
+          continue;
+      }
+    }
+    fields.push_back(SpaceUsedField{field, kind, schema_.InRealOneof(field)});
+  }
+  return fields;
+}
+
+namespace {
+
+// Returns the message types reachable from `root` that may have required
+// fields, either themselves or in any message reachable from them. Types with
+// extension ranges are assumed to, since an extension may contain required
+// fields. Each type and edge is visited once, however many fields lead to it.
+absl::flat_hash_set<const Descriptor*> TypesWithRequiredFields(
+    const Descriptor* root) {
+  // Reverse edges: for each reachable type, the types that point at it.
+  absl::flat_hash_map<const Descriptor*, std::vector<const Descriptor*>>
+      parents = {{root, {}}};
+  std::vector<const Descriptor*> pending = {root};
+  std::vector<const Descriptor*> result_pending;
+  absl::flat_hash_set<const Descriptor*> result;
+  while (!pending.empty()) {
+    const Descriptor* type = pending.back();
+    pending.pop_back();
+    bool has_required = type->extension_range_count() > 0;
+    for (int i = 0; i < type->field_count(); i++) {
+      const FieldDescriptor* field = type->field(i);
+      has_required |= field->is_required();
+      if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) continue;
+      auto inserted = parents.try_emplace(field->message_type());
+      inserted.first->second.push_back(type);
+      if (inserted.second) pending.push_back(field->message_type());
+    }
+    if (has_required && result.insert(type).second) {
+      result_pending.push_back(type);
+    }
+  }
+  // Everything that can reach a type with required fields may have them too.
+  while (!result_pending.empty()) {
+    const Descriptor* type = result_pending.back();
+    result_pending.pop_back();
+    for (const Descriptor* parent : parents[type]) {
+      if (result.insert(parent).second) result_pending.push_back(parent);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+Reflection::InitializationFields Reflection::CreateInitializationFields()
+    const {
+  InitializationFields fields;
+  const absl::flat_hash_set<const Descriptor*> types_with_required_fields =
+      TypesWithRequiredFields(descriptor_);
+  for (int i = 0; i < descriptor_->field_count(); i++) {
+    const FieldDescriptor* field = descriptor_->field(i);
+    if (field->is_required()) {
+      fields.required.push_back(field);
+    }
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+        types_with_required_fields.contains(field->message_type())) {
+      fields.messages.push_back(field);
+    }
+  }
+  return fields;
+}
+
 size_t Reflection::SpaceUsedLong(const Message& message) const {
+  return SpaceUsedLongImpl(message, 0);
+}
+
+size_t Reflection::EstimateSpaceUsedLong(const Message& message,
+                                         int max_samples) const {
+  ABSL_DCHECK_GT(max_samples, 0);
+  return SpaceUsedLongImpl(message, max_samples);
+}
+
+size_t Reflection::SpaceUsedLongImpl(const Message& message,
+                                     int max_samples) const {
   // object_size_ already includes the in-memory representation of each field
   // in the message, so we only need to account for additional memory used by
   // the fields.
@@ -341,106 +465,94 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
   if (schema_.HasExtensionSet()) {
     total_size += GetExtensionSet(message).SpaceUsedExcludingSelfLong();
   }
-  for (int i = 0; i <= last_non_weak_field_index_; i++) {
-    const FieldDescriptor* field = descriptor_->field(i);
-    if (field->is_repeated()) {
-      switch (field->cpp_type()) {
-#define HANDLE_TYPE(UPPERCASE, LOWERCASE)                           \
-  case FieldDescriptor::CPPTYPE_##UPPERCASE:                        \
+  for (const SpaceUsedField& entry : GetSpaceUsedFields()) {
+    const FieldDescriptor* field = entry.field;
+    if (entry.in_real_oneof && !HasOneofField(message, field)) {
+      continue;
+    }
+    switch (entry.kind) {
+#define HANDLE_TYPE(KIND, LOWERCASE)                                \
+  case SpaceUsedField::KIND:                                        \
     total_size += GetRaw<RepeatedField<LOWERCASE> >(message, field) \
                       .SpaceUsedExcludingSelfLong();                \
     break
 
-        HANDLE_TYPE(INT32, int32_t);
-        HANDLE_TYPE(INT64, int64_t);
-        HANDLE_TYPE(UINT32, uint32_t);
-        HANDLE_TYPE(UINT64, uint64_t);
-        HANDLE_TYPE(DOUBLE, double);
-        HANDLE_TYPE(FLOAT, float);
-        HANDLE_TYPE(BOOL, bool);
-        HANDLE_TYPE(ENUM, int);
+      HANDLE_TYPE(kRepeatedInt32, int32_t);
+      HANDLE_TYPE(kRepeatedInt64, int64_t);
+      HANDLE_TYPE(kRepeatedUInt32, uint32_t);
+      HANDLE_TYPE(kRepeatedUInt64, uint64_t);
+      HANDLE_TYPE(kRepeatedDouble, double);
+      HANDLE_TYPE(kRepeatedFloat, float);
+      HANDLE_TYPE(kRepeatedBool, bool);
+      HANDLE_TYPE(kRepeatedEnum, int);
 #undef HANDLE_TYPE
 
-        case FieldDescriptor::CPPTYPE_STRING:
-          switch (field->options().ctype()) {
-            default:  // TODO(kenton):  Support other string reps.
-            case FieldOptions::STRING:
-              total_size +=
-                  GetRaw<RepeatedPtrField<std::string> >(message, field)
-                      .SpaceUsedExcludingSelfLong();
-              break;
-          }
-          break;
-
-        case FieldDescriptor::CPPTYPE_MESSAGE:
-          if (IsMapFieldInApi(field)) {
-            total_size += GetRaw<internal::MapFieldBase>(message, field)
-                              .SpaceUsedExcludingSelfLong();
-          } else {
-            // We don't know which subclass of RepeatedPtrFieldBase the type is,
-            // so we use RepeatedPtrFieldBase directly.
-            total_size +=
-                GetRaw<RepeatedPtrFieldBase>(message, field)
-                    .SpaceUsedExcludingSelfLong<GenericTypeHandler<Message> >();
-          }
+      case SpaceUsedField::kRepeatedString:
+        total_size += GetRaw<RepeatedPtrField<std::string> >(message, field)
+                          .SpaceUsedExcludingSelfLong();
+        break;
 
+      case SpaceUsedField::kRepeatedMessage: {
+        // We don't know which subclass of RepeatedPtrFieldBase the type is,
+        // so we use RepeatedPtrFieldBase directly.
+        const auto& repeated = GetRaw<RepeatedPtrFieldBase>(message, field);
+        if (max_samples == 0) {
+          total_size += repeated.SpaceUsedExcludingSelfLong<
+              GenericTypeHandler<Message> >();
           break;
+        }
+        total_size += repeated.EstimateSpaceUsedExcludingSelfLong<
+            GenericTypeHandler<Message> >(
+            max_samples, [&](const Message& element) {
+              return element.GetReflection()->SpaceUsedLongImpl(element,
+                                                                max_samples);
+            });
+        break;
       }
-    } else {
-      if (schema_.InRealOneof(field) && !HasOneofField(message, field)) {
-        continue;
+
+      case SpaceUsedField::kMap:
+        total_size += GetRaw<internal::MapFieldBase>(message, field)
+                          .SpaceUsedExcludingSelfLong();
+        break;
+
+      case SpaceUsedField::kInlinedString: {
+        const std::string* ptr =
+            &GetField<InlinedStringField>(message, field).GetNoArena();
+        total_size += StringSpaceUsedExcludingSelfLong(*ptr);
+        break;
       }
-      switch (field->cpp_type()) {
-        case FieldDescriptor::CPPTYPE_INT32:
-        case FieldDescriptor::CPPTYPE_INT64:
-        case FieldDescriptor::CPPTYPE_UINT32:
-        case FieldDescriptor::CPPTYPE_UINT64:
-        case FieldDescriptor::CPPTYPE_DOUBLE:
-        case FieldDescriptor::CPPTYPE_FLOAT:
-        case FieldDescriptor::CPPTYPE_BOOL:
-        case FieldDescriptor::CPPTYPE_ENUM:
-          // Field is inline, so we've already counted it.
-          break;
 
-        case FieldDescriptor::CPPTYPE_STRING: {
-          switch (field->options().ctype()) {
-            default:  // TODO(kenton):  Support other string reps.
-            case FieldOptions::STRING:
-              if (IsInlined(field)) {
-                const std::string* ptr =
-                    &GetField<InlinedStringField>(message, field).GetNoArena();
-                total_size += StringSpaceUsedExcludingSelfLong(*ptr);
-              } else {
-                // Initially, the string points to the default value stored
-                // in the prototype. Only count the string if it has been
-                // changed from the default value.
-                // Except oneof fields, those never point to a default instance,
-                // and there is no default instance to point to.
-                const auto& str = GetField<ArenaStringPtr>(message, field);
-                if (!str.IsDefault() || schema_.InRealOneof(field)) {
-                  // string fields are represented by just a pointer, so also
-                  // include sizeof(string) as well.
-                  total_size += sizeof(std::string) +
-                                StringSpaceUsedExcludingSelfLong(str.Get());
-                }
-              }
-              break;
-          }
-          break;
+      case SpaceUsedField::kString: {
+        // Initially, the string points to the default value stored
+        // in the prototype. Only count the string if it has been
+        // changed from the default value.
+        // Except oneof fields, those never point to a default instance,
+        // and there is no default instance to point to.
+        const auto& str = GetField<ArenaStringPtr>(message, field);
+        if (!str.IsDefault() || entry.in_real_oneof) {
+          // string fields are represented by just a pointer, so also
+          // include sizeof(string) as well.
+          total_size +=
+              sizeof(std::string) + StringSpaceUsedExcludingSelfLong(str.Get());
         }
+        break;
+      }
 
-        case FieldDescriptor::CPPTYPE_MESSAGE:
-          if (schema_.IsDefaultInstance(message)) {
-            // For singular fields, the prototype just stores a pointer to the
-            // external type's prototype, so there is no extra memory usage.
-          } else {
-            const Message* sub_message = GetRaw<const Message*>(message, field);
-            if (sub_message != nullptr) {
-              total_size += sub_message->SpaceUsedLong();
-            }
+      case SpaceUsedField::kMessage:
+        if (schema_.IsDefaultInstance(message)) {
+          // For singular fields, the prototype just stores a pointer to the
+          // external type's prototype, so there is no extra memory usage.
+        } else {
+          const Message* sub_message = GetRaw<const Message*>(message, field);
+          if (sub_message != nullptr) {
+            total_size +=
+                max_samples == 0
+                    ? sub_message->SpaceUsedLong()
+                    : sub_message->GetReflection()->SpaceUsedLongImpl(
+                          *sub_message, max_samples);
           }
-          break;
-      }
+        }
+        break;
     }
   }
 #ifndef PROTOBUF_FUZZ_MESSAGE_SPACE_USED_LONG
@@ -1557,10 +1669,9 @@ bool CreateUnknownEnumValues(const FieldDescriptor* field) {
 }  // namespace internal
 using internal::CreateUnknownEnumValues;
 
-void Reflection::ListFields(const Message& message,
-                            std::vector<const FieldDescriptor*>* output) const {
-  output->clear();
-
+template <typename Func>
+void Reflection::ForEachSetNonExtensionField(const Message& message,
+                                             Func func) const {
   // Optimization:  The default instance never has any fields set.
   if (schema_.IsDefaultInstance(message)) return;
 
@@ -1572,19 +1683,12 @@ void Reflection::ListFields(const Message& message,
   const uint32_t* const has_bits =
       schema_.HasHasbits() ? GetHasBits(message) : nullptr;
   const uint32_t* const has_bits_indices = schema_.has_bit_indices_;
-  output->reserve(descriptor_->field_count());
   const int last_non_weak_field_index = last_non_weak_field_index_;
-  // Fields in messages are usually added with the increasing tags.
-  uint32_t last = 0;  // UINT32_MAX if out-of-order
-  auto append_to_output = [&last, &output](const FieldDescriptor* field) {
-    CheckInOrder(field, &last);
-    output->push_back(field);
-  };
   for (int i = 0; i <= last_non_weak_field_index; i++) {
     const FieldDescriptor* field = descriptor_->field(i);
     if (field->is_repeated()) {
       if (FieldSize(message, field) > 0) {
-        append_to_output(field);
+        func(field);
       }
     } else {
       const OneofDescriptor* containing_oneof = field->containing_oneof();
@@ -1595,18 +1699,45 @@ void Reflection::ListFields(const Message& message,
         // Equivalent to: HasOneofField(message, field)
         if (static_cast<int64_t>(oneof_case_array[containing_oneof->index()]) ==
             field->number()) {
-          append_to_output(field);
+          func(field);
         }
       } else if (has_bits && has_bits_indices[i] != static_cast<uint32_t>(-1)) {
         // Equivalent to: HasBit(message, field)
         if (IsIndexInHasBitSet(has_bits, has_bits_indices[i])) {
-          append_to_output(field);
+          func(field);
         }
       } else if (HasBit(message, field)) {  // Fall back on proto3-style HasBit.
-        append_to_output(field);
+        func(field);
       }
     }
   }
+}
+
+void Reflection::ForEachSetField(
+    const Message& message,
+    absl::FunctionRef<void(const FieldDescriptor*)> func) const {
+  ForEachSetNonExtensionField(message, func);
+  if (schema_.HasExtensionSet()) {
+    GetExtensionSet(message).ForEachPresent(descriptor_, descriptor_pool_,
+                                            func);
+  }
+}
+
+void Reflection::ListFields(const Message& message,
+                            std::vector<const FieldDescriptor*>* output) const {
+  output->clear();
+
+  // Optimization:  The default instance never has any fields set.
+  if (schema_.IsDefaultInstance(message)) return;
+
+  output->reserve(descriptor_->field_count());
+  // Fields in messages are usually added with the increasing tags.
+  uint32_t last = 0;  // UINT32_MAX if out-of-order
+  ForEachSetNonExtensionField(
+      message, [&last, &output](const FieldDescriptor* field) {
+        CheckInOrder(field, &last);
+        output->push_back(field);
+      });
   // Descriptors of ExtensionSet are appended in their increasing tag
   // order and they are usually bigger than the field tags so if all fields are
   // not sorted, let them be sorted.
@@ -3077,6 +3208,8 @@ void Reflection::PopulateTcParseEntries(
 
 void Reflection::PopulateTcParseFieldAux(
     const internal::TailCallTableInfo& table_info,
+    absl::FunctionRef<const TcParseTableBase*(const FieldDescriptor*)>
+        sub_table,
     TcParseTableBase::FieldAux* field_aux) const {
   for (const auto& aux_entry : table_info.aux_entries) {
     switch (aux_entry.type) {
@@ -3094,6 +3227,8 @@ void Reflection::PopulateTcParseFieldAux(
         field_aux++->offset = schema_.SizeofSplit();
         break;
       case internal::TailCallTableInfo::kSubTable:
+        field_aux++->table = sub_table(aux_entry.field);
+        break;
       case internal::TailCallTableInfo::kSubMessageWeak:
       case internal::TailCallTableInfo::kCreateInArena:
       case internal::TailCallTableInfo::kMessageVerifyFunc:
@@ -3132,13 +3267,29 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
   }
 
   std::vector<const FieldDescriptor*> fields;
+  fields.reserve(static_cast<size_t>(descriptor_->field_count()));
+  for (int i = 0; i < descriptor_->field_count(); ++i) {
+    fields.push_back(descriptor_->field(i));
+  }
+  return CreateTcParseTable(
+      std::move(fields),
+      [](const FieldDescriptor*) -> const TcParseTableBase* { return nullptr; },
+      &internal::TcParser::ReflectionFallback);
+}
+
+const internal::TcParseTableBase* Reflection::CreateTcParseTable(
+    std::vector<const FieldDescriptor*> fields,
+    absl::FunctionRef<const TcParseTableBase*(const FieldDescriptor*)>
+        sub_table,
+    internal::TailCallParseFunc fallback) const {
+  using TcParseTableBase = internal::TcParseTableBase;
+
   constexpr int kNoHasbit = -1;
   std::vector<int> has_bit_indices(
       static_cast<size_t>(descriptor_->field_count()), kNoHasbit);
   std::vector<int> inlined_string_indices = has_bit_indices;
   for (int i = 0; i < descriptor_->field_count(); ++i) {
     auto* field = descriptor_->field(i);
-    fields.push_back(field);
     has_bit_indices[static_cast<size_t>(field->index())] =
         static_cast<int>(schema_.HasBitIndex(field));
 
@@ -3155,7 +3306,11 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
   class ReflectionOptionProvider final
       : public internal::TailCallTableInfo::OptionProvider {
    public:
-    explicit ReflectionOptionProvider(const Reflection& ref) : ref_(ref) {}
+    ReflectionOptionProvider(
+        const Reflection& ref,
+        absl::FunctionRef<const TcParseTableBase*(const FieldDescriptor*)>
+            sub_table)
+        : ref_(ref), sub_table_(sub_table) {}
     internal::TailCallTableInfo::PerFieldOptions GetForField(
         const FieldDescriptor* field) const final {
       const auto verify_flag = [&] {
@@ -3172,22 +3327,25 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
           // Only LITE can be implicitly weak.
           /* is_implicitly_weak */ false,
 
-          // We could change this to use direct table.
-          // Might be easier to do when all messages support TDP.
-          /* use_direct_tcparser_table */ false,
+          // Submessages are parsed with their own table, unless the caller
+          // supplied a different one.
+          /* use_direct_tcparser_table */ sub_table_(field) != nullptr,
 
-          /* is_lite */ false,          //
-          ref_.schema_.IsSplit(field),  //
-          /* uses_codegen */ false      //
+          /* is_lite */ false,               //
+          ref_.schema_.IsSplit(field),       //
+          /* uses_codegen */ false,          //
+          /* presence_probability */ 1.0f,  //
       };
     }
 
    private:
     const Reflection& ref_;
+    absl::FunctionRef<const TcParseTableBase*(const FieldDescriptor*)>
+        sub_table_;
   };
   internal::TailCallTableInfo table_info(
-      descriptor_, fields, ReflectionOptionProvider(*this), has_bit_indices,
-      inlined_string_indices);
+      descriptor_, fields, ReflectionOptionProvider(*this, sub_table),
+      has_bit_indices, inlined_string_indices);
 
   const size_t fast_entries_count = table_info.fast_path_fields.size();
   ABSL_CHECK_EQ(fast_entries_count, 1 << table_info.table_size_log2);
@@ -3221,7 +3379,7 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
       static_cast<uint16_t>(table_info.aux_entries.size()),
       aux_offset,
       schema_.default_instance_,
-      &internal::TcParser::ReflectionFallback};
+      fallback};
 
   // Now copy the rest of the payloads
   PopulateTcParseFastEntries(table_info, res->fast_entry(0));
@@ -3230,7 +3388,7 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
 
   PopulateTcParseEntries(table_info, res->field_entries_begin());
 
-  PopulateTcParseFieldAux(table_info, res->field_aux(0u));
+  PopulateTcParseFieldAux(table_info, sub_table, res->field_aux(0u));
 
   // Copy the name data.
   if (!table_info.field_name_data.empty()) {
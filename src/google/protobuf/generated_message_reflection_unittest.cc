@@ -93,8 +93,10 @@ class GeneratedMessageReflectionTestHelper {
 namespace {
 
 using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 using ::testing::Pointee;
 using ::testing::Property;
+using ::testing::UnorderedElementsAreArray;
 
 // Shorthand to get a FieldDescriptor for a field of unittest::TestAllTypes.
 const FieldDescriptor* F(const std::string& name) {
@@ -1382,6 +1384,58 @@ TEST(GeneratedMessageReflection, IsDescendantOneof) {
       IsDescendant(msg1, msg2.foo_message().repeated_foreign_message(0)));
 }
 
+TEST(GeneratedMessageReflection, SpaceUsedLong) {
+  unittest::TestAllTypes message;
+  const Reflection* reflection = message.GetReflection();
+  const size_t empty_size = reflection->SpaceUsedLong(message);
+
+  // Scalars live inside the object.
+  message.set_optional_int32(1);
+  message.set_optional_double(2);
+  EXPECT_EQ(empty_size, reflection->SpaceUsedLong(message));
+
+  message.set_optional_string(std::string(100, 'x'));
+  const size_t with_string = reflection->SpaceUsedLong(message);
+  EXPECT_GE(with_string, empty_size + 100);
+
+  message.add_repeated_int64(1);
+  message.mutable_optional_nested_message()->set_bb(1);
+  message.set_oneof_string(std::string(100, 'y'));
+  EXPECT_GT(reflection->SpaceUsedLong(message), with_string + 100);
+}
+
+TEST(GeneratedMessageReflection, EstimateSpaceUsedLong) {
+  unittest::TestAllTypes message;
+  for (int i = 0; i < 1000; ++i) {
+    message.add_repeated_nested_message()->set_bb(i);
+  }
+  message.set_optional_string(std::string(100, 'x'));
+  const Reflection* reflection = message.GetReflection();
+
+  // All elements are the same size, so sampling a few of them is enough to
+  // get close to the exact value.
+  const size_t exact = reflection->SpaceUsedLong(message);
+  const size_t estimate = reflection->EstimateSpaceUsedLong(message, 10);
+  EXPECT_GT(estimate, exact * 95 / 100);
+  EXPECT_LT(estimate, exact * 105 / 100);
+}
+
+TEST(GeneratedMessageReflection, EstimateSpaceUsedLongCountsClearedElements) {
+  unittest::TestAllTypes message;
+  for (int i = 0; i < 1000; ++i) {
+    message.add_repeated_nested_message()->set_bb(i);
+  }
+  // Cleared elements stay allocated and are counted like SpaceUsedLong()
+  // counts them.
+  message.mutable_repeated_nested_message()->Clear();
+  const Reflection* reflection = message.GetReflection();
+
+  const size_t exact = reflection->SpaceUsedLong(message);
+  const size_t estimate = reflection->EstimateSpaceUsedLong(message, 10);
+  EXPECT_GT(estimate, exact * 95 / 100);
+  EXPECT_LT(estimate, exact * 105 / 100);
+}
+
 TEST(GeneratedMessageReflection, ListFieldsSorted) {
   unittest::TestFieldOrderings msg;
   const Reflection* reflection = msg.GetReflection();
@@ -1427,6 +1481,40 @@ TEST(GeneratedMessageReflection, ListFieldsSorted) {
                           Pointee(Property(&FieldDescriptor::number, 101))));
 }
 
+TEST(GeneratedMessageReflection, ForEachSetField) {
+  unittest::TestFieldOrderings msg;
+  const Reflection* reflection = msg.GetReflection();
+  std::vector<const FieldDescriptor*> visited;
+  auto collect = [&visited](const FieldDescriptor* field) {
+    visited.push_back(field);
+  };
+  reflection->ForEachSetField(msg, collect);
+  EXPECT_THAT(visited, IsEmpty());
+
+  msg.set_my_string("hello");  // tag 11
+  msg.set_my_int(4242);        // tag 1
+  msg.SetExtension(unittest::my_extension_string, "hello");  // tag 50
+  msg.SetExtension(unittest::my_extension_int, 424242);      // tag 5
+  reflection->ForEachSetField(msg, collect);
+  // Declaration order, then extensions by number.
+  EXPECT_THAT(visited,
+              ElementsAre(Pointee(Property(&FieldDescriptor::number, 11)),
+                          Pointee(Property(&FieldDescriptor::number, 1)),
+                          Pointee(Property(&FieldDescriptor::number, 5)),
+                          Pointee(Property(&FieldDescriptor::number, 50))));
+
+  // Visits the same fields as ListFields().
+  unittest::TestAllTypes all;
+  TestUtil::SetAllFields(&all);
+  all.clear_optional_int32();
+  all.clear_repeated_string();
+  std::vector<const FieldDescriptor*> listed;
+  all.GetReflection()->ListFields(all, &listed);
+  visited.clear();
+  all.GetReflection()->ForEachSetField(all, collect);
+  EXPECT_THAT(visited, UnorderedElementsAreArray(listed));
+}
+
 }  // namespace
 }  // namespace protobuf
 }  // namespace google
@@ -29,6 +29,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cstdint>
+#include <string>
 
 #include "google/protobuf/extension_set.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
@@ -81,6 +82,45 @@ const char* TcParser::ReflectionFallback(PROTOBUF_TC_PARAM_DECL) {
                                                  reflection, field);
 }
 
+template <bool kKeepUnknown>
+const char* TcParser::ProjectionFallbackImpl(PROTOBUF_TC_PARAM_DECL) {
+  if (PROTOBUF_PREDICT_FALSE(MustFallbackToGeneric(PROTOBUF_TC_PARAM_PASS))) {
+    PROTOBUF_MUSTTAIL return GenericFallback(PROTOBUF_TC_PARAM_PASS);
+  }
+
+  uint32_t tag = data.tag();
+  if (tag != 0 && (tag & 7) != WireFormatLite::WIRETYPE_END_GROUP &&
+      FindFieldEntry(table, tag >> 3) != nullptr) {
+    // A selected field that the table does not parse by itself, e.g. a map.
+    PROTOBUF_MUSTTAIL return ReflectionFallback(PROTOBUF_TC_PARAM_PASS);
+  }
+
+  SyncHasbits(msg, hasbits, table);
+  if (tag == 0 || (tag & 7) == WireFormatLite::WIRETYPE_END_GROUP) {
+    ctx->SetLastTag(tag);
+    return ptr;
+  }
+  if (kKeepUnknown) {
+    // Extensions are kept as unknown fields too, rather than being parsed
+    // into the extension set.
+    return UnknownFieldParse(
+        tag, msg->_internal_metadata_.mutable_unknown_fields<UnknownFieldSet>(),
+        ptr, ctx);
+  }
+  // Skip the field without decoding it.
+  return UnknownFieldParse(tag, static_cast<std::string*>(nullptr), ptr, ctx);
+}
+
+const char* TcParser::ProjectionFallback(PROTOBUF_TC_PARAM_DECL) {
+  PROTOBUF_MUSTTAIL return ProjectionFallbackImpl<false>(
+      PROTOBUF_TC_PARAM_PASS);
+}
+
+const char* TcParser::ProjectionFallbackKeepUnknown(PROTOBUF_TC_PARAM_DECL) {
+  PROTOBUF_MUSTTAIL return ProjectionFallbackImpl<true>(
+      PROTOBUF_TC_PARAM_PASS);
+}
+
 const char* TcParser::ReflectionParseLoop(PROTOBUF_TC_PARAM_DECL) {
   (void)data;
   (void)table;
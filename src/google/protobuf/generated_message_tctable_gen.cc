@@ -51,6 +51,10 @@ namespace internal {
 
 namespace {
 
+// Fields present in fewer parsed messages than this are not given a fast-table
+// entry, leaving it to a likelier field with the same low tag bits.
+constexpr float kColdFieldPresence = 0.005f;
+
 bool GetEnumValidationRange(const EnumDescriptor* enum_type, int16_t& start,
                             uint16_t& size) {
   ABSL_CHECK_GT(enum_type->value_count(), 0) << enum_type->DebugString();
@@ -256,6 +260,10 @@ bool IsFieldEligibleForFastParsing(
     return false;
   }
 
+  if (options.presence_probability < kColdFieldPresence) {
+    return false;
+  }
+
   if (HasLazyRep(field, options) && !options.uses_codegen) {
     // Can't use TDP on lazy fields if we can't do codegen.
     return false;
@@ -379,11 +387,26 @@ std::vector<TailCallTableInfo::FastFieldInfo> SplitFastFieldsForSize(
     info.nonfield_info = *end_group_tag;
   }
 
+  // Fields are placed from the likeliest to the least likely, so that the
+  // likelier field gets the entry when several map to the same one. Among
+  // equally likely fields, the lowest field number wins.
+  std::vector<const TailCallTableInfo::FieldEntryInfo*> fast_entries;
   for (const auto& entry : field_entries) {
-    if (!IsFieldEligibleForFastParsing(entry, option_provider)) {
-      continue;
+    if (IsFieldEligibleForFastParsing(entry, option_provider)) {
+      fast_entries.push_back(&entry);
     }
-
+  }
+  const auto presence = [&](const TailCallTableInfo::FieldEntryInfo* entry) {
+    return option_provider.GetForField(entry->field).presence_probability;
+  };
+  std::stable_sort(fast_entries.begin(), fast_entries.end(),
+                   [&](const TailCallTableInfo::FieldEntryInfo* a,
+                       const TailCallTableInfo::FieldEntryInfo* b) {
+                     return presence(a) > presence(b);
+                   });
+
+  for (const auto* entry_ptr : fast_entries) {
+    const auto& entry = *entry_ptr;
     const auto* field = entry.field;
     const auto options = option_provider.GetForField(field);
     const uint32_t tag = RecodeTagForFastParsing(WireFormat::MakeTag(field));
@@ -880,23 +903,34 @@ TailCallTableInfo::TailCallTableInfo(
     }
   }
 
+  for (const auto& entry : field_entries) {
+    if (IsFieldEligibleForFastParsing(entry, option_provider)) {
+      ++num_fast_eligible_fields;
+    }
+  }
+
   table_size_log2 = 0;  // fallback value
-  int num_fast_fields = -1;
+  float fast_presence = -1;
   auto end_group_tag = GetEndGroupTag(descriptor);
   for (int try_size_log2 : {0, 1, 2, 3, 4, 5}) {
     size_t try_size = 1 << try_size_log2;
     auto split_fields = SplitFastFieldsForSize(end_group_tag, field_entries,
                                                try_size_log2, option_provider);
     ABSL_CHECK_EQ(split_fields.size(), try_size);
-    int try_num_fast_fields = 0;
+    // The expected number of fields per message that the table parses. Without
+    // presence estimates this is the number of fast fields.
+    float try_fast_presence = 0;
     for (const auto& info : split_fields) {
-      if (info.field != nullptr) ++try_num_fast_fields;
+      if (info.field != nullptr) {
+        try_fast_presence +=
+            option_provider.GetForField(info.field).presence_probability;
+      }
     }
     // Use this size if (and only if) it covers more fields.
-    if (try_num_fast_fields > num_fast_fields) {
+    if (try_fast_presence > fast_presence) {
       fast_path_fields = std::move(split_fields);
       table_size_log2 = try_size_log2;
-      num_fast_fields = try_num_fast_fields;
+      fast_presence = try_fast_presence;
     }
     // The largest table we allow has the same number of entries as the
     // message has fields, rounded up to the next power of 2 (e.g., a message
@@ -65,6 +65,10 @@ struct PROTOBUF_EXPORT TailCallTableInfo {
     bool is_lite;
     bool should_split;
     bool uses_codegen;
+    // Estimated fraction of parsed messages that contain the field, or 1 if
+    // unknown. Likelier fields win collisions for a fast-table entry, and
+    // fields that are almost never present get no fast entry at all.
+    float presence_probability;
   };
   class OptionProvider {
    public:
@@ -90,6 +94,10 @@ struct PROTOBUF_EXPORT TailCallTableInfo {
     uint16_t nonfield_info;
   };
   std::vector<FastFieldInfo> fast_path_fields;
+  // Number of fields that could be parsed by the fast path if the table had
+  // room for all of them. Fields with 3-byte tags, maps, cold fields and the
+  // like are not counted.
+  int num_fast_eligible_fields = 0;
 
   // Fields parsed by mini parsing routines.
   struct FieldEntryInfo {
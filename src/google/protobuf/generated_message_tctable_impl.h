@@ -412,6 +412,13 @@ class PROTOBUF_EXPORT TcParser final {
   static const char* ReflectionFallback(PROTOBUF_TC_PARAM_DECL);
   static const char* ReflectionParseLoop(PROTOBUF_TC_PARAM_DECL);
 
+  // Fallbacks for tables that only contain some of a message's fields (see
+  // util::FieldMaskParser). Fields in the table are handled like
+  // ReflectionFallback() does; any other field is skipped, or kept as an
+  // unknown field.
+  static const char* ProjectionFallback(PROTOBUF_TC_PARAM_DECL);
+  static const char* ProjectionFallbackKeepUnknown(PROTOBUF_TC_PARAM_DECL);
+
   static const char* ParseLoop(MessageLite* msg, const char* ptr,
                                ParseContext* ctx,
                                const TcParseTableBase* table);
@@ -686,6 +693,9 @@ class PROTOBUF_EXPORT TcParser final {
   template <typename TagType>
   static const char* FastEndGroupImpl(PROTOBUF_TC_PARAM_DECL);
 
+  template <bool kKeepUnknown>
+  static const char* ProjectionFallbackImpl(PROTOBUF_TC_PARAM_DECL);
+
   static inline PROTOBUF_ALWAYS_INLINE void SyncHasbits(
       MessageLite* msg, uint64_t hasbits, const TcParseTableBase* table) {
     const uint32_t has_bits_offset = table->has_bits_offset;
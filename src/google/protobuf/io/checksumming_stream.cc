@@ -0,0 +1,208 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/io/checksumming_stream.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "absl/log/absl_check.h"
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+namespace {
+
+#if !defined(__SSE4_2__) && !defined(__ARM_FEATURE_CRC32)
+
+// Lookup tables for the software implementation, which processes eight bytes
+// per step ("slicing-by-8").  table[0] is the usual bytewise table for the
+// reflected Castagnoli polynomial; table[k][b] is the CRC of byte b followed
+// by k zero bytes.
+struct Crc32cTables {
+  constexpr Crc32cTables() : table() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+      }
+      table[0][i] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+      for (int i = 0; i < 256; ++i) {
+        uint32_t prev = table[k - 1][i];
+        table[k][i] = (prev >> 8) ^ table[0][prev & 0xFF];
+      }
+    }
+  }
+
+  uint32_t table[8][256];
+};
+
+constexpr Crc32cTables kCrc32cTables;
+
+uint32_t LoadLittleEndian32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+#endif
+
+}  // namespace
+
+uint32_t ExtendCrc32c(uint32_t crc, const void* data, size_t size) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint32_t l = ~crc;
+#if defined(__SSE4_2__) && defined(__x86_64__)
+  for (; size >= 8; p += 8, size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    l = static_cast<uint32_t>(_mm_crc32_u64(l, word));
+  }
+  for (; size > 0; ++p, --size) l = _mm_crc32_u8(l, *p);
+#elif defined(__SSE4_2__)
+  for (; size >= 4; p += 4, size -= 4) {
+    uint32_t word;
+    std::memcpy(&word, p, sizeof(word));
+    l = _mm_crc32_u32(l, word);
+  }
+  for (; size > 0; ++p, --size) l = _mm_crc32_u8(l, *p);
+#elif defined(__ARM_FEATURE_CRC32)
+  for (; size >= 8; p += 8, size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+#if defined(__ARM_BIG_ENDIAN)
+    word = __builtin_bswap64(word);
+#endif
+    l = __crc32cd(l, word);
+  }
+  for (; size > 0; ++p, --size) l = __crc32cb(l, *p);
+#else
+  const auto& table = kCrc32cTables.table;
+  for (; size >= 8; p += 8, size -= 8) {
+    uint32_t lo = LoadLittleEndian32(p) ^ l;
+    uint32_t hi = LoadLittleEndian32(p + 4);
+    l = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^
+        table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+        table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^
+        table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+  }
+  for (; size > 0; ++p, --size) l = (l >> 8) ^ table[0][(l ^ *p) & 0xFF];
+#endif
+  return ~l;
+}
+
+// ===================================================================
+
+uint32_t ChecksummingInputStream::Checksum() const {
+  return ExtendCrc32c(crc_, pending_, pending_size_);
+}
+
+void ChecksummingInputStream::ChecksumPending() {
+  crc_ = ExtendCrc32c(crc_, pending_, pending_size_);
+  pending_size_ = 0;
+}
+
+bool ChecksummingInputStream::Next(const void** data, int* size) {
+  ChecksumPending();
+  if (!sub_stream_->Next(data, size)) return false;
+  pending_ = *data;
+  pending_size_ = *size;
+  return true;
+}
+
+void ChecksummingInputStream::BackUp(int count) {
+  ABSL_DCHECK_LE(count, pending_size_);
+  // Checksum the rest now: once the sub stream has taken the bytes back, the
+  // buffer may be refilled or freed by its next call.
+  pending_size_ -= count;
+  ChecksumPending();
+  sub_stream_->BackUp(count);
+}
+
+bool ChecksummingInputStream::Skip(int count) {
+  // Skipped bytes are part of the checksum, so they have to be read.
+  while (count > 0) {
+    const void* data;
+    int size;
+    if (!Next(&data, &size)) return false;
+    if (size > count) {
+      BackUp(size - count);
+      return true;
+    }
+    count -= size;
+  }
+  return true;
+}
+
+// ===================================================================
+
+uint32_t ChecksummingOutputStream::Checksum() const {
+  return ExtendCrc32c(crc_, pending_, pending_size_);
+}
+
+void ChecksummingOutputStream::ChecksumPending() {
+  crc_ = ExtendCrc32c(crc_, pending_, pending_size_);
+  pending_size_ = 0;
+}
+
+bool ChecksummingOutputStream::Next(void** data, int* size) {
+  ChecksumPending();
+  if (!sub_stream_->Next(data, size)) return false;
+  pending_ = *data;
+  pending_size_ = *size;
+  return true;
+}
+
+void ChecksummingOutputStream::BackUp(int count) {
+  ABSL_DCHECK_LE(count, pending_size_);
+  // Checksum the rest now: once the sub stream has taken the bytes back, the
+  // buffer may be refilled or freed by its next call.
+  pending_size_ -= count;
+  ChecksumPending();
+  sub_stream_->BackUp(count);
+}
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,131 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains ChecksummingInputStream and ChecksummingOutputStream,
+// which compute the CRC32C of the data read from or written to another
+// stream without copying it.
+
+#ifndef GOOGLE_PROTOBUF_IO_CHECKSUMMING_STREAM_H__
+#define GOOGLE_PROTOBUF_IO_CHECKSUMMING_STREAM_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/port.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+// Returns the CRC32C (Castagnoli) of `size` bytes at `data` appended to data
+// whose CRC32C is `crc`. Start from 0 for the first chunk. Uses the CRC32
+// instructions of SSE4.2 or ARMv8 when the target has them.
+PROTOBUF_EXPORT uint32_t ExtendCrc32c(uint32_t crc, const void* data,
+                                      size_t size);
+
+// A ZeroCopyInputStream that reads from another stream and computes the
+// CRC32C of the bytes read. Bytes returned with BackUp() are not part of the
+// checksum; bytes passed over with Skip() are.
+class PROTOBUF_EXPORT ChecksummingInputStream final
+    : public ZeroCopyInputStream {
+ public:
+  // Does not take ownership of sub_stream.
+  explicit ChecksummingInputStream(ZeroCopyInputStream* sub_stream)
+      : sub_stream_(sub_stream) {}
+  ChecksummingInputStream(const ChecksummingInputStream&) = delete;
+  ChecksummingInputStream& operator=(const ChecksummingInputStream&) = delete;
+  ~ChecksummingInputStream() override = default;
+
+  // Returns the CRC32C of all bytes read so far.
+  uint32_t Checksum() const;
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override { return sub_stream_->ByteCount(); }
+
+ private:
+  // Adds what is left of the buffer returned by the last Next() to crc_. This
+  // is delayed until the caller backs up or asks for the next buffer.
+  void ChecksumPending();
+
+  ZeroCopyInputStream* sub_stream_;
+  uint32_t crc_ = 0;
+  const void* pending_ = nullptr;
+  int pending_size_ = 0;
+};
+
+// A ZeroCopyOutputStream that writes to another stream and computes the
+// CRC32C of the bytes written. The buffers are those of the underlying
+// stream, so the data is not copied.
+class PROTOBUF_EXPORT ChecksummingOutputStream final
+    : public ZeroCopyOutputStream {
+ public:
+  // Does not take ownership of sub_stream.
+  explicit ChecksummingOutputStream(ZeroCopyOutputStream* sub_stream)
+      : sub_stream_(sub_stream) {}
+  ChecksummingOutputStream(const ChecksummingOutputStream&) = delete;
+  ChecksummingOutputStream& operator=(const ChecksummingOutputStream&) =
+      delete;
+  ~ChecksummingOutputStream() override = default;
+
+  // Returns the CRC32C of all bytes written so far. The caller must have
+  // backed up any unused part of the last buffer, as for ByteCount().
+  uint32_t Checksum() const;
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override { return sub_stream_->ByteCount(); }
+
+ private:
+  // Adds what is left of the buffer returned by the last Next() to crc_. This
+  // is delayed until the caller backs up or asks for the next buffer, by which
+  // time it has been filled.
+  void ChecksumPending();
+
+  ZeroCopyOutputStream* sub_stream_;
+  uint32_t crc_ = 0;
+  const void* pending_ = nullptr;
+  int pending_size_ = 0;
+};
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_IO_CHECKSUMMING_STREAM_H__
@@ -523,6 +523,17 @@ class PROTOBUF_EXPORT CodedInputStream {
   // factory has been provided.
   MessageFactory* GetExtensionFactory();
 
+  // If enabled, MessageSet items parsed from this stream are kept in
+  // serialized form when their type is found in the generated extension
+  // registry, and are only parsed when first accessed. Items that are never
+  // accessed are serialized again by copying their bytes. The bytes are
+  // checked to be well-formed wire format while parsing, but errors inside an
+  // item that need its type, such as invalid UTF-8, only show up when it is
+  // accessed. Disabled by default. Ignored for lite messages and when an
+  // extension registry is set.
+  void SetLazyMessageSetItems(bool enabled);
+  bool LazyMessageSetItems() const;
+
  private:
   const uint8_t* buffer_;
   const uint8_t* buffer_end_;  // pointer to the end of the buffer.
@@ -571,6 +582,8 @@ class PROTOBUF_EXPORT CodedInputStream {
   // See SetExtensionRegistry().
   const DescriptorPool* extension_pool_;
   MessageFactory* extension_factory_;
+  // See SetLazyMessageSetItems().
+  bool lazy_message_set_items_;
 
   // Private member functions.
 
@@ -895,7 +908,13 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
     auto end = it + r.size();
     do {
       ptr = EnsureSpace(ptr);
-      ptr = UnsafeVarint(encode(*it++), ptr);
+      // A stream always has the slop region after EnsureSpace(), an array
+      // (see the array constructor) only has room up to end_.
+      if (PROTOBUF_PREDICT_TRUE(stream_ != nullptr || end_ - ptr >= 8)) {
+        ptr = UnsafeVarintInSlop(encode(*it++), ptr);
+      } else {
+        ptr = UnsafeVarint(encode(*it++), ptr);
+      }
     } while (it < end);
     return ptr;
   }
@@ -922,6 +941,47 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
     return ptr;
   }
 
+  // Like UnsafeVarint(), but writes each group of 8 bytes with a single
+  // store instead of a loop whose exit depends on the value, which is
+  // mispredicted when the sizes of consecutive values vary. It may write up to
+  // 7 bytes past the end of the varint, so it is only safe where the buffer
+  // has room for at least 8 bytes, e.g. within the slop region after
+  // EnsureSpace().
+  PROTOBUF_ALWAYS_INLINE static uint8_t* UnsafeVarintInSlop(uint64_t value,
+                                                            uint8_t* ptr) {
+#if defined(PROTOBUF_LITTLE_ENDIAN) && \
+    !defined(PROTOBUF_DISABLE_LITTLE_ENDIAN_OPT_FOR_TEST)
+    // Single byte values are common enough that skipping the bit spreading
+    // is worth a branch.
+    if (value < 0x80) {
+      *ptr = static_cast<uint8_t>(value);
+      return ptr + 1;
+    }
+    // Spread the low 56 bits into the low 7 bits of each byte.
+    uint64_t bytes = (value & 0x7f) | ((value << 1) & 0x7f00) |
+                     ((value << 2) & 0x7f0000) | ((value << 3) & 0x7f000000) |
+                     ((value << 4) & 0x7f00000000) |
+                     ((value << 5) & 0x7f0000000000) |
+                     ((value << 6) & 0x7f000000000000) |
+                     ((value << 7) & 0x7f00000000000000);
+    if (PROTOBUF_PREDICT_TRUE(value < (uint64_t{1} << 56))) {
+      // Same as CodedOutputStream::VarintSize64(), which is declared later.
+      uint32_t log2value = 63 - absl::countl_zero(value | 0x1);
+      uint32_t size = (log2value * 9 + 73) / 64;
+      // Set the continuation bit of all but the last byte.
+      bytes |= uint64_t{0x0080808080808080} &
+               ((uint64_t{1} << (size * 8 - 8)) - 1);
+      std::memcpy(ptr, &bytes, sizeof(bytes));
+      return ptr + size;
+    }
+    bytes |= uint64_t{0x8080808080808080};
+    std::memcpy(ptr, &bytes, sizeof(bytes));
+    return UnsafeVarint(value >> 56, ptr + sizeof(bytes));
+#else
+    return UnsafeVarint(value, ptr);
+#endif
+  }
+
   PROTOBUF_ALWAYS_INLINE static uint8_t* UnsafeWriteSize(uint32_t value,
                                                          uint8_t* ptr) {
     while (PROTOBUF_PREDICT_FALSE(value >= 0x80)) {
@@ -1564,6 +1624,14 @@ inline MessageFactory* CodedInputStream::GetExtensionFactory() {
   return extension_factory_;
 }
 
+inline void CodedInputStream::SetLazyMessageSetItems(bool enabled) {
+  lazy_message_set_items_ = enabled;
+}
+
+inline bool CodedInputStream::LazyMessageSetItems() const {
+  return lazy_message_set_items_;
+}
+
 inline int CodedInputStream::BufferSize() const {
   return static_cast<int>(buffer_end_ - buffer_);
 }
@@ -1583,7 +1651,8 @@ inline CodedInputStream::CodedInputStream(ZeroCopyInputStream* input)
       recursion_budget_(default_recursion_limit_),
       recursion_limit_(default_recursion_limit_),
       extension_pool_(nullptr),
-      extension_factory_(nullptr) {
+      extension_factory_(nullptr),
+      lazy_message_set_items_(false) {
   // Eagerly Refresh() so buffer space is immediately available.
   Refresh();
 }
@@ -1603,7 +1672,8 @@ inline CodedInputStream::CodedInputStream(const uint8_t* buffer, int size)
       recursion_budget_(default_recursion_limit_),
       recursion_limit_(default_recursion_limit_),
       extension_pool_(nullptr),
-      extension_factory_(nullptr) {
+      extension_factory_(nullptr),
+      lazy_message_set_items_(false) {
   // Note that setting current_limit_ == size is important to prevent some
   // code paths from trying to access input_ and segfaulting.
 }
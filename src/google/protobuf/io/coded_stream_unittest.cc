@@ -360,6 +360,74 @@ TEST_2D(CodedStreamTest, WriteVarint64, kVarintCases, kBlockSizes) {
             memcmp(buffer_, kVarintCases_case.bytes, kVarintCases_case.size));
 }
 
+TEST_1D(CodedStreamTest, WriteVarintPacked, kBlockSizes) {
+  // Every varint length, with all bits of each group set and cleared.
+  std::vector<uint64_t> values = {0, ~uint64_t{0}};
+  for (int bits = 1; bits < 64; ++bits) {
+    values.push_back(uint64_t{1} << bits);
+    values.push_back((uint64_t{1} << bits) - 1);
+  }
+
+  std::string expected;
+  int size = 0;
+  {
+    StringOutputStream expected_output(&expected);
+    CodedOutputStream coded_output(&expected_output);
+    coded_output.WriteTag((1 << 3) | 2);  // Field 1, length-delimited.
+    for (uint64_t value : values) {
+      size += CodedOutputStream::VarintSize64(value);
+    }
+    coded_output.WriteVarint32(size);
+    for (uint64_t value : values) coded_output.WriteVarint64(value);
+  }
+
+  ArrayOutputStream output(buffer_, sizeof(buffer_), kBlockSizes_case);
+  {
+    CodedOutputStream coded_output(&output);
+    coded_output.SetCur(coded_output.EpsCopy()->WriteUInt64Packed(
+        1, values, size, coded_output.Cur()));
+    EXPECT_FALSE(coded_output.HadError());
+  }
+
+  ASSERT_EQ(expected.size(), output.ByteCount());
+  EXPECT_EQ(expected, absl::string_view(reinterpret_cast<char*>(buffer_),
+                                        expected.size()));
+}
+
+TEST_F(CodedStreamTest, WriteVarintPackedToArray) {
+  // Array serialization has no slop region, so the last few values must not
+  // write past the end of the array.
+  std::vector<uint64_t> values;
+  for (int bits = 0; bits < 64; ++bits) values.push_back(uint64_t{1} << bits);
+  values.push_back(300);
+  values.push_back(1);
+
+  int size = 0;
+  for (uint64_t value : values) size += CodedOutputStream::VarintSize64(value);
+  std::string expected;
+  {
+    StringOutputStream expected_output(&expected);
+    CodedOutputStream coded_output(&expected_output);
+    coded_output.WriteTag((1 << 3) | 2);  // Field 1, length-delimited.
+    coded_output.WriteVarint32(size);
+    for (uint64_t value : values) coded_output.WriteVarint64(value);
+  }
+
+  // Fill the bytes after the array with a marker.
+  memset(buffer_, 0xab, sizeof(buffer_));
+  ASSERT_LT(expected.size() + 16, sizeof(buffer_));
+  EpsCopyOutputStream stream(buffer_, static_cast<int>(expected.size()),
+                             false);
+  uint8_t* end = stream.WriteUInt64Packed(1, values, size, buffer_);
+
+  EXPECT_EQ(buffer_ + expected.size(), end);
+  EXPECT_EQ(expected, absl::string_view(reinterpret_cast<char*>(buffer_),
+                                        expected.size()));
+  for (size_t i = expected.size(); i < expected.size() + 16; ++i) {
+    EXPECT_EQ(0xab, buffer_[i]) << i;
+  }
+}
+
 // This test causes gcc 3.3.5 (and earlier?) to give the cryptic error:
 //   "sorry, unimplemented: `method_call_expr' not supported by dump_expr"
 #if !defined(__GNUC__) || __GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ > 3)
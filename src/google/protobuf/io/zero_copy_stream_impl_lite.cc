@@ -689,6 +689,15 @@ int64_t CordOutputStream::ByteCount() const {
   return static_cast<int64_t>(cord_.size() + buffer_.length());
 }
 
+bool CordOutputStream::WriteAliasedRaw(const void* data, int size) {
+  ABSL_DCHECK(aliasing_enabled_);
+  cord_.Append(std::move(buffer_));
+  cord_.Append(absl::MakeCordFromExternal(
+      absl::string_view(static_cast<const char*>(data), size), [] {}));
+  state_ = State::kSteal;  // Attempt to utilize existing capacity in `cord'
+  return true;
+}
+
 bool CordOutputStream::WriteCord(const absl::Cord& cord) {
   cord_.Append(std::move(buffer_));
   cord_.Append(cord);
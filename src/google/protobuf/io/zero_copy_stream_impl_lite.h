@@ -481,10 +481,30 @@ class PROTOBUF_EXPORT CordOutputStream final : public ZeroCopyOutputStream {
   CordOutputStream(const CordOutputStream&) = delete;
   CordOutputStream& operator=(const CordOutputStream&) = delete;
 
+  // Enables `WriteAliasedRaw()`, which appends the data to the cord as an
+  // external reference instead of copying it. Together with aliasing enabled
+  // on the `CodedOutputStream`, large string and bytes fields are referenced
+  // rather than copied when serializing:
+  //
+  //   CordOutputStream stream;
+  //   stream.EnableAliasing(true);
+  //   {
+  //     CodedOutputStream coded(&stream);
+  //     coded.EnableAliasing(true);
+  //     message.SerializeToCodedStream(&coded);
+  //   }
+  //   absl::Cord cord = stream.Consume();
+  //
+  // The caller must ensure that aliased data, `message` above, outlives the
+  // resulting cord and all copies made of it. Disabled by default.
+  void EnableAliasing(bool enabled) { aliasing_enabled_ = enabled; }
+
   // implements `ZeroCopyOutputStream` ---------------------------------
   bool Next(void** data, int* size) final;
   void BackUp(int count) final;
   int64_t ByteCount() const final;
+  bool WriteAliasedRaw(const void* data, int size) final;
+  bool AllowsAliasing() const final { return aliasing_enabled_; }
   bool WriteCord(const absl::Cord& cord) final;
 
   // Consumes the serialized data as a cord value. `Consume()` internally
@@ -510,6 +530,7 @@ class PROTOBUF_EXPORT CordOutputStream final : public ZeroCopyOutputStream {
   size_t size_hint_;
   State state_ = State::kEmpty;
   absl::CordBuffer buffer_;
+  bool aliasing_enabled_ = false;
 };
 
 
@@ -77,6 +77,7 @@
 #include "absl/strings/cord_buffer.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "google/protobuf/io/checksumming_stream.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/io_win32.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
@@ -313,6 +314,64 @@ TEST_F(IoTest, ArrayIo) {
   }
 }
 
+TEST_F(IoTest, Crc32c) {
+  // Check values from RFC 3720, section B.4, and the usual "123456789".
+  EXPECT_EQ(ExtendCrc32c(0, "123456789", 9), 0xE3069283u);
+  std::string zeros(32, '\0');
+  EXPECT_EQ(ExtendCrc32c(0, zeros.data(), zeros.size()), 0x8A9136AAu);
+  std::string ones(32, '\xFF');
+  EXPECT_EQ(ExtendCrc32c(0, ones.data(), ones.size()), 0x62A8AB43u);
+  EXPECT_EQ(ExtendCrc32c(0, nullptr, 0), 0u);
+
+  // Extending chunk by chunk gives the checksum of the whole.
+  std::string text = "The quick brown fox jumps over the lazy dog.";
+  uint32_t whole = ExtendCrc32c(0, text.data(), text.size());
+  for (size_t split = 0; split <= text.size(); ++split) {
+    uint32_t crc = ExtendCrc32c(0, text.data(), split);
+    EXPECT_EQ(ExtendCrc32c(crc, text.data() + split, text.size() - split),
+              whole);
+  }
+}
+
+TEST_F(IoTest, ChecksummingIo) {
+  const int kBufferSize = 256;
+  uint8_t buffer[kBufferSize];
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      int size;
+      uint32_t written;
+      {
+        ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[i]);
+        ChecksummingOutputStream checksummed(&output);
+        size = WriteStuff(&checksummed);
+        written = checksummed.Checksum();
+      }
+      EXPECT_EQ(written, ExtendCrc32c(0, buffer, size));
+      {
+        // ReadStuff() skips some of the data; it still counts as read.
+        ArrayInputStream input(buffer, size, kBlockSizes[j]);
+        ChecksummingInputStream checksummed(&input);
+        ReadStuff(&checksummed);
+        EXPECT_EQ(checksummed.Checksum(), written);
+      }
+    }
+  }
+}
+
+TEST_F(IoTest, ChecksummingInputExcludesBackedUpBytes) {
+  const std::string data = "0123456789";
+  ArrayInputStream input(data.data(), data.size());
+  ChecksummingInputStream checksummed(&input);
+  const void* buffer;
+  int size;
+  ASSERT_TRUE(checksummed.Next(&buffer, &size));
+  ASSERT_EQ(size, 10);
+  checksummed.BackUp(6);
+  EXPECT_EQ(checksummed.ByteCount(), 4);
+  EXPECT_EQ(checksummed.Checksum(), ExtendCrc32c(0, data.data(), 4));
+}
+
 TEST_F(IoTest, TwoSessionWrite) {
   // Test that two concatenated write sessions read correctly
 
@@ -1320,6 +1379,45 @@ TEST(CordOutputStreamTest, UsesPrivateCapacityInAppendedCord) {
   EXPECT_EQ(flat, absl::StrCat(std::string(500, 'a'), std::string(1500, 'b')));
 }
 
+TEST(CordOutputStreamTest, AliasingIsOptIn) {
+  CordOutputStream output;
+  EXPECT_FALSE(output.AllowsAliasing());
+  output.EnableAliasing(true);
+  EXPECT_TRUE(output.AllowsAliasing());
+}
+
+TEST(CordOutputStreamTest, WriteAliasedRawReferencesData) {
+  std::string blob(65536, 'b');
+  CordOutputStream output;
+  output.EnableAliasing(true);
+  {
+    CodedOutputStream coded(&output);
+    coded.EnableAliasing(true);
+    coded.WriteString("head");
+    coded.WriteRawMaybeAliased(blob.data(), static_cast<int>(blob.size()));
+    coded.WriteString("tail");
+  }
+  absl::Cord cord = output.Consume();
+  EXPECT_EQ(cord, absl::StrCat("head", blob, "tail"));
+
+  // The blob is referenced rather than copied: the cord sees later changes.
+  blob[0] = 'x';
+  EXPECT_EQ(cord.Subcord(4, 1), "x");
+}
+
+TEST(CordOutputStreamTest, WritesCopyWithoutAliasing) {
+  std::string blob(65536, 'b');
+  CordOutputStream output;
+  {
+    CodedOutputStream coded(&output);
+    coded.EnableAliasing(true);
+    coded.WriteRawMaybeAliased(blob.data(), static_cast<int>(blob.size()));
+  }
+  absl::Cord cord = output.Consume();
+  blob[0] = 'x';
+  EXPECT_EQ(cord, std::string(65536, 'b'));
+}
+
 TEST(CordOutputStreamTest, CapsSizeAtHintButUsesCapacityBeyondHint) {
   // This tests verifies that when we provide a hint of 'x' bytes, that the
   // returned size from Next() will be capped at 'size_hint', but that if we
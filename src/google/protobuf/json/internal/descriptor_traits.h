@@ -480,14 +480,15 @@ struct Proto3Type {
     auto e = f->EnumType();
     RETURN_IF_ERROR(e.status());
 
-    for (const auto& ev : (**e).proto().enumvalue()) {
-      if (case_insensitive) {
-        // Two ifs to avoid doing operator== twice if the names are not equal.
+    if (!case_insensitive) {
+      if (const auto* ev = (**e).FindValue(name)) {
+        return ev->number();
+      }
+    } else {
+      for (const auto& ev : (**e).proto().enumvalue()) {
         if (absl::EqualsIgnoreCase(ev.name(), name)) {
           return ev.number();
         }
-      } else if (ev.name() == name) {
-        return ev.number();
       }
     }
     return absl::InvalidArgumentError(
@@ -498,10 +499,8 @@ struct Proto3Type {
     auto e = f->EnumType();
     RETURN_IF_ERROR(e.status());
 
-    for (const auto& ev : (**e).proto().enumvalue()) {
-      if (ev.number() == number) {
-        return ev.name();
-      }
+    if (const auto* ev = (**e).FindValue(number)) {
+      return ev->name();
     }
     return absl::InvalidArgumentError(
         absl::StrFormat("unknown enum number: '%d'", number));
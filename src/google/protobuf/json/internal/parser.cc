@@ -1362,8 +1362,8 @@ absl::Status JsonToBinaryStream(google::protobuf::util::TypeResolver* resolver,
     Msg<ParseProto3Type> msg(tee_output.has_value() ? &*tee_output
                                                     : binary_output);
 
-    ResolverPool pool(resolver);
-    auto desc = pool.FindMessage(type_url);
+    ScopedResolverPool pool(resolver);
+    auto desc = pool->FindMessage(type_url);
     RETURN_IF_ERROR(desc.status());
 
     s = ParseMessage<ParseProto3Type>(lex, **desc, msg, /*any_reparse=*/false);
@@ -898,8 +898,8 @@ absl::Status BinaryToJsonStream(google::protobuf::util::TypeResolver* resolver,
 
   PROTOBUF_DLOG(INFO) << "json2/input: " << absl::BytesToHexString(copy);
 
-  ResolverPool pool(resolver);
-  auto desc = pool.FindMessage(type_url);
+  ScopedResolverPool pool(resolver);
+  auto desc = pool->FindMessage(type_url);
   RETURN_IF_ERROR(desc.status());
 
   io::CodedInputStream stream(tee_input.has_value() ? &*tee_input
@@ -47,6 +47,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
@@ -93,11 +94,11 @@ absl::StatusOr<const ResolverPool::Enum*> ResolverPool::Field::EnumType()
 
 absl::Span<const ResolverPool::Field> ResolverPool::Message::FieldsByIndex()
     const {
-  if (raw_.fields_size() > 0 && fields_ == nullptr) {
-    fields_ = std::unique_ptr<Field[]>(new Field[raw_.fields_size()]);
-    for (size_t i = 0; i < raw_.fields_size(); ++i) {
+  if (raw_->fields_size() > 0 && fields_ == nullptr) {
+    fields_ = std::unique_ptr<Field[]>(new Field[raw_->fields_size()]);
+    for (size_t i = 0; i < raw_->fields_size(); ++i) {
       fields_[i].pool_ = pool_;
-      fields_[i].raw_ = &raw_.fields(i);
+      fields_[i].raw_ = &raw_->fields(i);
       fields_[i].parent_ = this;
     }
   }
@@ -107,7 +108,7 @@ absl::Span<const ResolverPool::Field> ResolverPool::Message::FieldsByIndex()
 
 const ResolverPool::Field* ResolverPool::Message::FindField(
     absl::string_view name) const {
-  if (raw_.fields_size() == 0) {
+  if (raw_->fields_size() == 0) {
     return nullptr;
   }
 
@@ -129,11 +130,11 @@ const ResolverPool::Field* ResolverPool::Message::FindField(
 
 const ResolverPool::Field* ResolverPool::Message::FindField(
     int32_t number) const {
-  if (raw_.fields_size() == 0) {
+  if (raw_->fields_size() == 0) {
     return nullptr;
   }
 
-  bool is_small = raw_.fields_size() < 8;
+  bool is_small = raw_->fields_size() < 8;
   if (is_small || fields_by_number_.empty()) {
     const Field* found = nullptr;
     for (auto& field : FieldsByIndex()) {
@@ -151,6 +152,42 @@ const ResolverPool::Field* ResolverPool::Message::FindField(
   return it == fields_by_number_.end() ? nullptr : it->second;
 }
 
+const google::protobuf::EnumValue* ResolverPool::Enum::FindValue(
+    absl::string_view name) const {
+  if (raw_->enumvalue_size() < 8) {
+    for (const auto& value : raw_->enumvalue()) {
+      if (value.name() == name) return &value;
+    }
+    return nullptr;
+  }
+
+  if (values_by_name_.empty()) {
+    for (const auto& value : raw_->enumvalue()) {
+      values_by_name_.try_emplace(value.name(), &value);
+    }
+  }
+  auto it = values_by_name_.find(name);
+  return it == values_by_name_.end() ? nullptr : it->second;
+}
+
+const google::protobuf::EnumValue* ResolverPool::Enum::FindValue(
+    int32_t number) const {
+  if (raw_->enumvalue_size() < 8) {
+    for (const auto& value : raw_->enumvalue()) {
+      if (value.number() == number) return &value;
+    }
+    return nullptr;
+  }
+
+  if (values_by_number_.empty()) {
+    for (const auto& value : raw_->enumvalue()) {
+      values_by_number_.try_emplace(value.number(), &value);
+    }
+  }
+  auto it = values_by_number_.find(number);
+  return it == values_by_number_.end() ? nullptr : it->second;
+}
+
 absl::StatusOr<const ResolverPool::Message*> ResolverPool::FindMessage(
     absl::string_view url) {
   auto it = messages_.find(url);
@@ -160,7 +197,9 @@ absl::StatusOr<const ResolverPool::Message*> ResolverPool::FindMessage(
 
   auto msg = absl::WrapUnique(new Message(this));
   std::string url_buf(url);
-  RETURN_IF_ERROR(resolver_->ResolveMessageType(url_buf, &msg->raw_));
+  auto type = resolver_->FindMessageType(url_buf);
+  RETURN_IF_ERROR(type.status());
+  msg->raw_ = *std::move(type);
 
   return messages_.try_emplace(std::move(url_buf), std::move(msg))
       .first->second.get();
@@ -175,12 +214,62 @@ absl::StatusOr<const ResolverPool::Enum*> ResolverPool::FindEnum(
 
   auto enoom = absl::WrapUnique(new Enum(this));
   std::string url_buf(url);
-  RETURN_IF_ERROR(resolver_->ResolveEnumType(url_buf, &enoom->raw_));
+  auto type = resolver_->FindEnumType(url_buf);
+  RETURN_IF_ERROR(type.status());
+  enoom->raw_ = *std::move(type);
 
   return enums_.try_emplace(std::move(url_buf), std::move(enoom))
       .first->second.get();
 }
 
+namespace {
+// Pools kept for reuse by ScopedResolverPool, least recently used first.
+struct IdlePools {
+  // Pools of resolvers that are gone or have moved on to a new token are never
+  // asked for again; the bound makes sure they are eventually dropped.
+  static constexpr size_t kMaxPools = 8;
+
+  absl::Mutex mutex;
+  std::vector<std::unique_ptr<ResolverPool>> pools ABSL_GUARDED_BY(mutex);
+};
+
+IdlePools& GetIdlePools() {
+  static auto* idle = new IdlePools;
+  return *idle;
+}
+}  // namespace
+
+ScopedResolverPool::ScopedResolverPool(
+    google::protobuf::util::TypeResolver* resolver) {
+  uint64_t token = resolver->ResolutionToken();
+  if (token != 0) {
+    IdlePools& idle = GetIdlePools();
+    absl::MutexLock lock(&idle.mutex);
+    for (auto it = idle.pools.rbegin(); it != idle.pools.rend(); ++it) {
+      if ((*it)->token_ == token) {
+        pool_ = std::move(*it);
+        idle.pools.erase(std::next(it).base());
+        return;
+      }
+    }
+  }
+  pool_ = std::make_unique<ResolverPool>(resolver);
+  pool_->token_ = token;
+}
+
+ScopedResolverPool::~ScopedResolverPool() {
+  if (pool_->token_ == 0 ||
+      pool_->resolver_->ResolutionToken() != pool_->token_) {
+    return;
+  }
+  IdlePools& idle = GetIdlePools();
+  absl::MutexLock lock(&idle.mutex);
+  if (idle.pools.size() >= IdlePools::kMaxPools) {
+    idle.pools.erase(idle.pools.begin());
+  }
+  idle.pools.push_back(std::move(pool_));
+}
+
 absl::Status UntypedMessage::Decode(io::CodedInputStream& stream,
                                     absl::optional<int32_t> current_group) {
   while (true) {
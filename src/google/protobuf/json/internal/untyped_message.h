@@ -112,7 +112,7 @@ class ResolverPool {
     const Field* FindField(absl::string_view name) const;
     const Field* FindField(int32_t number) const;
 
-    const google::protobuf::Type& proto() const { return raw_; }
+    const google::protobuf::Type& proto() const { return *raw_; }
     ResolverPool* pool() const { return pool_; }
 
    private:
@@ -121,7 +121,7 @@ class ResolverPool {
     explicit Message(ResolverPool* pool) : pool_(pool) {}
 
     ResolverPool* pool_;
-    google::protobuf::Type raw_;
+    std::shared_ptr<const google::protobuf::Type> raw_;
     mutable std::unique_ptr<Field[]> fields_;
     mutable absl::flat_hash_map<absl::string_view, const Field*>
         fields_by_name_;
@@ -133,7 +133,11 @@ class ResolverPool {
     Enum(const Enum&) = delete;
     Enum& operator=(const Enum&) = delete;
 
-    const google::protobuf::Enum& proto() const { return raw_; }
+    // Returns the first value with the given name or number, or nullptr.
+    const google::protobuf::EnumValue* FindValue(absl::string_view name) const;
+    const google::protobuf::EnumValue* FindValue(int32_t number) const;
+
+    const google::protobuf::Enum& proto() const { return *raw_; }
     ResolverPool* pool() const { return pool_; }
 
    private:
@@ -142,9 +146,12 @@ class ResolverPool {
     explicit Enum(ResolverPool* pool) : pool_(pool) {}
 
     ResolverPool* pool_;
-    google::protobuf::Enum raw_;
-    mutable absl::flat_hash_map<absl::string_view, google::protobuf::EnumValue*>
-        values_;
+    std::shared_ptr<const google::protobuf::Enum> raw_;
+    mutable absl::flat_hash_map<absl::string_view,
+                                const google::protobuf::EnumValue*>
+        values_by_name_;
+    mutable absl::flat_hash_map<int32_t, const google::protobuf::EnumValue*>
+        values_by_number_;
   };
 
   explicit ResolverPool(google::protobuf::util::TypeResolver* resolver)
@@ -157,9 +164,34 @@ class ResolverPool {
   absl::StatusOr<const Enum*> FindEnum(absl::string_view url);
 
  private:
+  friend class ScopedResolverPool;
+
   absl::flat_hash_map<std::string, std::unique_ptr<Message>> messages_;
   absl::flat_hash_map<std::string, std::unique_ptr<Enum>> enums_;
   google::protobuf::util::TypeResolver* resolver_;
+  // The resolver's ResolutionToken() when this pool was created.
+  uint64_t token_ = 0;
+};
+
+// A ResolverPool for a single conversion.
+//
+// If the resolver promises through ResolutionToken() that its results stay
+// current, the pool is not destroyed afterwards but kept for the next
+// conversion with the same token, so that its types and field indices are not
+// rebuilt on every call. Each pool is used by one conversion at a time.
+class ScopedResolverPool {
+ public:
+  explicit ScopedResolverPool(google::protobuf::util::TypeResolver* resolver);
+  ~ScopedResolverPool();
+
+  ScopedResolverPool(const ScopedResolverPool&) = delete;
+  ScopedResolverPool& operator=(const ScopedResolverPool&) = delete;
+
+  ResolverPool& operator*() const { return *pool_; }
+  ResolverPool* operator->() const { return pool_.get(); }
+
+ private:
+  std::unique_ptr<ResolverPool> pool_;
 };
 
 // A parsed wire-format proto that uses TypeReslover for parsing.
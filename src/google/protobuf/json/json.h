@@ -116,6 +116,9 @@ inline absl::Status JsonStringToMessage(absl::string_view input,
 //
 // Please note that non-OK statuses are not a stable output of this API and
 // subject to change without notice.
+//
+// Types are re-resolved on every call; callers converting many messages with
+// the same resolver should wrap it in a util::CachingTypeResolver.
 PROTOBUF_EXPORT absl::Status BinaryToJsonStream(
     google::protobuf::util::TypeResolver* resolver, const std::string& type_url,
     io::ZeroCopyInputStream* binary_input,
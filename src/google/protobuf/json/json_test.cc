@@ -42,6 +42,7 @@
 #include "google/protobuf/struct.pb.h"
 #include "google/protobuf/timestamp.pb.h"
 #include "google/protobuf/wrappers.pb.h"
+#include "google/protobuf/descriptor.pb.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/status/status.h"
@@ -1048,6 +1049,24 @@ TEST_P(JsonTest, TestParsingEnumIgnoreCase) {
   EXPECT_EQ(m.enum_value(), proto3::BAR);
 }
 
+TEST_P(JsonTest, TestLargeEnum) {
+  // FieldDescriptorProto.Type has enough values to be looked up through an
+  // index rather than a linear scan.
+  auto m = ToProto<FieldDescriptorProto>(
+      R"json({"label": "LABEL_REPEATED", "type": "TYPE_SINT64"})json");
+  ASSERT_OK(m);
+  EXPECT_EQ(m->label(), FieldDescriptorProto::LABEL_REPEATED);
+  EXPECT_EQ(m->type(), FieldDescriptorProto::TYPE_SINT64);
+  EXPECT_THAT(
+      ToJson(*m),
+      IsOkAndHolds(R"({"label":"LABEL_REPEATED","type":"TYPE_SINT64"})"));
+
+  EXPECT_THAT(
+      ToProto<FieldDescriptorProto>(R"json({"type": "TYPE_NOPE"})json")
+          .status(),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST_P(JsonTest, Extensions) {
   if (GetParam() == Codec::kResolver) {
     GTEST_SKIP();
@@ -509,6 +509,28 @@ TYPED_TEST(LiteTest, AllLite13CordStream) {
   }
 }
 
+TEST(LiteBasicTest, AppendToCordWithAliasingSharesFieldBuffer) {
+  protobuf_unittest::TestAllTypesLite message;
+  message.set_optional_int32(1);
+  message.set_optional_bytes(std::string(100000, 'x'));
+  const char* field_data = message.optional_bytes().data();
+
+  absl::Cord cord;
+  ASSERT_TRUE(message.AppendPartialToCordWithAliasing(&cord));
+  EXPECT_EQ(cord, message.SerializeAsString());
+
+  bool shared = false;
+  for (absl::string_view chunk : cord.Chunks()) {
+    if (chunk.data() == field_data) shared = true;
+  }
+  EXPECT_TRUE(shared);
+
+  // The default path copies.
+  for (absl::string_view chunk : message.SerializeAsCord().Chunks()) {
+    EXPECT_NE(chunk.data(), field_data);
+  }
+}
+
 TYPED_TEST(LiteTest, AllLite14) {
   {
     // Test Clear with unknown fields
@@ -136,7 +136,8 @@ class MapAllocator {
     // If arena is not given, malloc needs to be called which doesn't
     // construct element object.
     if (arena_ == nullptr) {
-      return static_cast<pointer>(::operator new(n * sizeof(value_type)));
+      return static_cast<pointer>(
+          internal::AllocateHeap(n * sizeof(value_type)));
     } else {
       return reinterpret_cast<pointer>(
           Arena::CreateArray<uint8_t>(arena_, n * sizeof(value_type)));
@@ -145,7 +146,7 @@ class MapAllocator {
 
   void deallocate(pointer p, size_type n) {
     if (arena_ == nullptr) {
-      internal::SizedDelete(p, n * sizeof(value_type));
+      internal::DeallocateHeap(p, n * sizeof(value_type));
     }
   }
 
@@ -467,6 +468,7 @@ class PROTOBUF_EXPORT UntypedMapBase {
         seed_(0),
         index_of_first_non_null_(internal::kGlobalEmptyTableSize),
         table_(const_cast<TableEntryPtr*>(internal::kGlobalEmptyTable)),
+        cleared_nodes_(nullptr),
         alloc_(arena) {}
 
   UntypedMapBase(const UntypedMapBase&) = delete;
@@ -484,6 +486,7 @@ class PROTOBUF_EXPORT UntypedMapBase {
     std::swap(seed_, other->seed_);
     std::swap(index_of_first_non_null_, other->index_of_first_non_null_);
     std::swap(table_, other->table_);
+    std::swap(cleared_nodes_, other->cleared_nodes_);
     std::swap(alloc_, other->alloc_);
   }
 
@@ -566,6 +569,11 @@ class PROTOBUF_EXPORT UntypedMapBase {
 
   NodeBase* AllocNode(size_t node_size) {
     PROTOBUF_ASSUME(node_size % sizeof(NodeBase) == 0);
+    if (cleared_nodes_ != nullptr) {
+      NodeBase* node = cleared_nodes_;
+      cleared_nodes_ = node->next;
+      return node;
+    }
     return AllocFor<NodeBase>(alloc_).allocate(node_size / sizeof(NodeBase));
   }
 
@@ -578,6 +586,21 @@ class PROTOBUF_EXPORT UntypedMapBase {
     AllocFor<NodeBase>(alloc_).deallocate(node, node_size / sizeof(NodeBase));
   }
 
+  // Keeps the memory of a destroyed node for the next AllocNode() call. All
+  // nodes of a map have the same size, so any of them can be handed out again.
+  void RecycleNode(NodeBase* node) {
+    node->next = cleared_nodes_;
+    cleared_nodes_ = node;
+  }
+
+  void DeleteClearedNodes(size_t node_size) {
+    while (cleared_nodes_ != nullptr) {
+      NodeBase* next = cleared_nodes_->next;
+      DeallocNode(cleared_nodes_, node_size);
+      cleared_nodes_ = next;
+    }
+  }
+
   void DeleteTable(TableEntryPtr* table, size_type n) {
     AllocFor<TableEntryPtr>(alloc_).deallocate(table, n);
   }
@@ -622,6 +645,11 @@ class PROTOBUF_EXPORT UntypedMapBase {
   size_type seed_;
   size_type index_of_first_non_null_;
   TableEntryPtr* table_;  // an array with num_buckets_ entries
+  // Nodes released by clear() on a map without an arena, linked through
+  // NodeBase::next. Refilling the map after Clear(), e.g. when the message is
+  // parsed again, takes its nodes from here instead of the allocator. At most
+  // as many nodes are kept as the map has held at once.
+  NodeBase* cleared_nodes_;
   Allocator alloc_;
 };
 
@@ -1128,7 +1156,8 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
 
     if (this->alloc_.arena() == nullptr &&
         this->num_buckets_ != internal::kGlobalEmptyTableSize) {
-      clear();
+      ClearTable(/*recycle=*/false);
+      this->DeleteClearedNodes(sizeof(Node));
       this->DeleteTable(this->table_, this->num_buckets_);
     }
   }
@@ -1420,29 +1449,7 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
     }
   }
 
-  void clear() {
-    for (size_type b = 0; b < this->num_buckets_; b++) {
-      internal::NodeBase* node;
-      if (this->TableEntryIsNonEmptyList(b)) {
-        node = internal::TableEntryToNode(this->table_[b]);
-        this->table_[b] = TableEntryPtr{};
-      } else if (this->TableEntryIsTree(b)) {
-        Tree* tree = internal::TableEntryToTree<Tree>(this->table_[b]);
-        this->table_[b] = TableEntryPtr{};
-        node = NodeFromTreeIterator(tree->begin());
-        this->DestroyTree(tree);
-      } else {
-        continue;
-      }
-      do {
-        auto* next = node->next;
-        DestroyNode(static_cast<Node*>(node));
-        node = next;
-      } while (node != nullptr);
-    }
-    this->num_elements_ = 0;
-    this->index_of_first_non_null_ = this->num_buckets_;
-  }
+  void clear() { ClearTable(/*recycle=*/true); }
 
   // Assign
   Map& operator=(const Map& other) {
@@ -1479,6 +1486,38 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   struct Rank1 {};
   struct Rank0 : Rank1 {};
 
+  // Destroys all elements. With `recycle`, the memory of their nodes is kept
+  // for later insertions instead of being freed.
+  void ClearTable(bool recycle) {
+    for (size_type b = 0; b < this->num_buckets_; b++) {
+      internal::NodeBase* node;
+      if (this->TableEntryIsNonEmptyList(b)) {
+        node = internal::TableEntryToNode(this->table_[b]);
+        this->table_[b] = TableEntryPtr{};
+      } else if (this->TableEntryIsTree(b)) {
+        Tree* tree = internal::TableEntryToTree<Tree>(this->table_[b]);
+        this->table_[b] = TableEntryPtr{};
+        node = NodeFromTreeIterator(tree->begin());
+        this->DestroyTree(tree);
+      } else {
+        continue;
+      }
+      do {
+        auto* next = node->next;
+        if (recycle && this->alloc_.arena() == nullptr) {
+          static_cast<Node*>(node)->kv.first.~key_type();
+          static_cast<Node*>(node)->kv.second.~mapped_type();
+          this->RecycleNode(node);
+        } else {
+          DestroyNode(static_cast<Node*>(node));
+        }
+        node = next;
+      } while (node != nullptr);
+    }
+    this->num_elements_ = 0;
+    this->index_of_first_non_null_ = this->num_buckets_;
+  }
+
   // Linked-list nodes, as one would expect for a chaining hash table.
   struct Node : Base::KeyNode {
     static constexpr internal::MapNodeSizeInfoT size_info() {
@@ -220,8 +220,9 @@ void* CreateSplitMessageGeneric(Arena* arena, const void* default_split,
                                 size_t size, const void* message,
                                 const void* default_message) {
   ABSL_DCHECK_NE(message, default_message);
-  void* split =
-      (arena == nullptr) ? ::operator new(size) : arena->AllocateAligned(size);
+  // Freed with DeallocateHeap() by the generated destructor.
+  void* split = (arena == nullptr) ? AllocateHeap(size)
+                                   : arena->AllocateAligned(size);
   memcpy(split, default_split, size);
   return split;
 }
@@ -187,6 +187,7 @@ void PerformAbslStringify(
     absl::FunctionRef<void(absl::string_view)> append);  // text_format.cc
 }  // namespace internal
 namespace util {
+class FieldMaskParser;
 class MessageDifferencer;
 }
 
@@ -498,6 +499,12 @@ class PROTOBUF_EXPORT Reflection final {
   // Estimate the amount of memory used by the message object.
   size_t SpaceUsedLong(const Message& message) const;
 
+  // Like SpaceUsedLong(), but only measures up to `max_samples` elements of
+  // each repeated message field and extrapolates from their average. This
+  // bounds the cost for messages with very large repeated submessage fields,
+  // at the price of accuracy.
+  size_t EstimateSpaceUsedLong(const Message& message, int max_samples) const;
+
   PROTOBUF_DEPRECATED_MSG("Please use SpaceUsedLong() instead")
   int SpaceUsed(const Message& message) const {
     return internal::ToIntSize(SpaceUsedLong(message));
@@ -581,6 +588,14 @@ class PROTOBUF_EXPORT Reflection final {
   void ListFields(const Message& message,
                   std::vector<const FieldDescriptor*>* output) const;
 
+  // Calls `func` for every field that ListFields() would return, without
+  // allocating. Unlike ListFields(), the order is not by field number: regular
+  // fields are visited in declaration order, followed by extensions in
+  // increasing field number order.
+  void ForEachSetField(
+      const Message& message,
+      absl::FunctionRef<void(const FieldDescriptor*)> func) const;
+
   // Singular field getters ------------------------------------------
   // These get the value of a non-repeated field.  They return the default
   // value for fields that aren't set.
@@ -1066,6 +1081,69 @@ class PROTOBUF_EXPORT Reflection final {
   // contain weak fields, then this field equals descriptor_->field_count().
   int last_non_weak_field_index_;
 
+  // The fields whose memory is not already included in the object size, with
+  // how to measure them. Computed on first use so that SpaceUsedLong() does
+  // not have to look at every scalar field, and so that constructing the
+  // Reflection does not force lazily built field types.
+  struct SpaceUsedField {
+    enum Kind : uint8_t {
+      kRepeatedInt32,
+      kRepeatedInt64,
+      kRepeatedUInt32,
+      kRepeatedUInt64,
+      kRepeatedDouble,
+      kRepeatedFloat,
+      kRepeatedBool,
+      kRepeatedEnum,
+      kRepeatedString,
+      kRepeatedMessage,
+      kMap,
+      kString,
+      kInlinedString,
+      kMessage,
+    };
+    const FieldDescriptor* field;
+    Kind kind;
+    bool in_real_oneof;
+  };
+  mutable absl::once_flag space_used_fields_once_;
+  mutable std::vector<SpaceUsedField> space_used_fields_;
+
+  const std::vector<SpaceUsedField>& GetSpaceUsedFields() const {
+    absl::call_once(space_used_fields_once_,
+                    [&] { space_used_fields_ = CreateSpaceUsedFields(); });
+    return space_used_fields_;
+  }
+  std::vector<SpaceUsedField> CreateSpaceUsedFields() const;
+
+  // Implements SpaceUsedLong() (max_samples == 0) and
+  // EstimateSpaceUsedLong().
+  size_t SpaceUsedLongImpl(const Message& message, int max_samples) const;
+
+  // The fields ReflectionOps::IsInitialized() has to look at: the required
+  // fields, and the message fields whose type may transitively contain
+  // required fields. Message fields whose types can never be uninitialized are
+  // left out, so their subtrees are not visited. Computed on first use.
+  struct InitializationFields {
+    std::vector<const FieldDescriptor*> required;
+    std::vector<const FieldDescriptor*> messages;
+  };
+  mutable absl::once_flag initialization_fields_once_;
+  mutable InitializationFields initialization_fields_;
+
+  const InitializationFields& GetInitializationFields() const {
+    absl::call_once(initialization_fields_once_, [&] {
+      initialization_fields_ = CreateInitializationFields();
+    });
+    return initialization_fields_;
+  }
+  InitializationFields CreateInitializationFields() const;
+
+  // Calls `func` for every set non-extension field, in declaration order.
+  // Shared by ListFields() and ForEachSetField().
+  template <typename Func>
+  void ForEachSetNonExtensionField(const Message& message, Func func) const;
+
   // The table-driven parser table.
   // This table is generated on demand for Message types that did not override
   // _InternalParse. It uses the reflection information to do so.
@@ -1080,14 +1158,26 @@ class PROTOBUF_EXPORT Reflection final {
   }
 
   const TcParseTableBase* CreateTcParseTable() const;
+  // Creates a table that only parses `fields`. Message fields for which
+  // `sub_table` returns a table are parsed with that table instead of the
+  // submessage's own one. Everything else is handed to `fallback`. Used by
+  // util::FieldMaskParser.
+  const TcParseTableBase* CreateTcParseTable(
+      std::vector<const FieldDescriptor*> fields,
+      absl::FunctionRef<const TcParseTableBase*(const FieldDescriptor*)>
+          sub_table,
+      internal::TailCallParseFunc fallback) const;
   const TcParseTableBase* CreateTcParseTableForMessageSet() const;
   void PopulateTcParseFastEntries(
       const internal::TailCallTableInfo& table_info,
       TcParseTableBase::FastFieldEntry* fast_entries) const;
   void PopulateTcParseEntries(internal::TailCallTableInfo& table_info,
                               TcParseTableBase::FieldEntry* entries) const;
-  void PopulateTcParseFieldAux(const internal::TailCallTableInfo& table_info,
-                               TcParseTableBase::FieldAux* field_aux) const;
+  void PopulateTcParseFieldAux(
+      const internal::TailCallTableInfo& table_info,
+      absl::FunctionRef<const TcParseTableBase*(const FieldDescriptor*)>
+          sub_table,
+      TcParseTableBase::FieldAux* field_aux) const;
 
   template <typename T, typename Enable>
   friend class RepeatedFieldRef;
@@ -1100,6 +1190,7 @@ class PROTOBUF_EXPORT Reflection final {
   friend class GeneratedMessageReflectionTestHelper;
   friend class python::MapReflectionFriend;
   friend class python::MessageReflectionFriend;
+  friend class util::FieldMaskParser;
   friend class util::MessageDifferencer;
 #define GOOGLE_PROTOBUF_HAS_CEL_MAP_REFLECTION_FRIEND
   friend class expr::CelMapReflectionFriend;
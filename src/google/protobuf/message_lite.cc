@@ -229,6 +229,7 @@ bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
   ctx.TrackCorrectEnding();
   ctx.data().pool = input->GetExtensionPool();
   ctx.data().factory = input->GetExtensionFactory();
+  ctx.data().lazy_message_set_items = input->LazyMessageSetItems();
   ptr = _InternalParse(ptr, &ctx);
   if (PROTOBUF_PREDICT_FALSE(!ptr)) return false;
   ctx.BackUp(ptr);
@@ -554,10 +555,16 @@ bool MessageLite::AppendToCord(absl::Cord* output) const {
   return AppendPartialToCord(output);
 }
 
-bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
+namespace {
+
+// Shared by AppendPartialToCord() and AppendPartialToCordWithAliasing().
+// With `aliasing`, string and bytes fields that do not fit in the current
+// buffer are appended to `output` as external references.
+bool AppendPartialToCordImpl(const MessageLite& msg, absl::Cord* output,
+                             bool aliasing) {
   // For efficiency, we'd like to pass a size hint to CordOutputStream with
   // the exact total size expected.
-  const size_t size = ByteSizeLong();
+  const size_t size = msg.ByteSizeLong();
   const size_t total_size = size + output->size();
   if (size > INT_MAX) {
     ABSL_LOG(ERROR) << "Exceeded maximum protobuf size of 2GB.";
@@ -575,7 +582,7 @@ bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
     io::EpsCopyOutputStream out(
         target, static_cast<int>(available.size()),
         io::CodedOutputStream::IsDefaultSerializationDeterministic());
-    auto res = _InternalSerialize(target, &out);
+    auto res = msg._InternalSerialize(target, &out);
     ABSL_DCHECK_EQ(res, target + size);
     buffer.IncreaseLengthBy(size);
     output->Append(std::move(buffer));
@@ -588,10 +595,12 @@ bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
   buffer.SetLength(buffer.capacity());
   io::CordOutputStream output_stream(std::move(*output), std::move(buffer),
                                      total_size);
+  output_stream.EnableAliasing(aliasing);
   io::EpsCopyOutputStream out(
       target, static_cast<int>(available.size()), &output_stream,
       io::CodedOutputStream::IsDefaultSerializationDeterministic(), &target);
-  target = _InternalSerialize(target, &out);
+  out.EnableAliasing(aliasing);
+  target = msg._InternalSerialize(target, &out);
   out.Trim(target);
   if (out.HadError()) return false;
   *output = output_stream.Consume();
@@ -599,6 +608,16 @@ bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
   return true;
 }
 
+}  // namespace
+
+bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
+  return AppendPartialToCordImpl(*this, output, /*aliasing=*/false);
+}
+
+bool MessageLite::AppendPartialToCordWithAliasing(absl::Cord* output) const {
+  return AppendPartialToCordImpl(*this, output, /*aliasing=*/true);
+}
+
 bool MessageLite::SerializeToCord(absl::Cord* output) const {
   output->Clear();
   return AppendToCord(output);
@@ -41,6 +41,7 @@
 
 #include <climits>
 #include <iosfwd>
+#include <new>
 #include <string>
 
 #include "google/protobuf/stubs/common.h"
@@ -174,6 +175,48 @@ class PROTOBUF_EXPORT MessageLite {
   MessageLite& operator=(const MessageLite&) = delete;
   virtual ~MessageLite() = default;
 
+  // Messages created without an arena are allocated with the allocator
+  // installed by SetHeapAllocator(). Declaring these hides the global forms,
+  // so every form of new-expression is provided again here.
+  static void* operator new(size_t size) {
+    return internal::AllocateHeap(size);
+  }
+  static void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return internal::AllocateHeapNoThrow(size);
+  }
+  static void* operator new(size_t, void* p) noexcept { return p; }
+  static void operator delete(void* p, size_t size) {
+    internal::DeallocateHeap(p, size);
+  }
+  // Only called when a constructor throws after `new (std::nothrow)`.
+  static void operator delete(void* p, const std::nothrow_t&) noexcept {
+    internal::DeallocateHeapUnsized(p);
+  }
+  static void operator delete(void*, void*) noexcept {}
+#if defined(__cpp_aligned_new)
+  // Over-aligned subclasses keep using the global allocator.
+  static void* operator new(size_t size, std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+  }
+  static void* operator new(size_t size, std::align_val_t alignment,
+                            const std::nothrow_t& tag) noexcept {
+    return ::operator new(size, alignment, tag);
+  }
+  static void operator delete(void* p, size_t size,
+                              std::align_val_t alignment) {
+#if defined(__cpp_sized_deallocation)
+    ::operator delete(p, size, alignment);
+#else
+    (void)size;
+    ::operator delete(p, alignment);
+#endif
+  }
+  static void operator delete(void* p, std::align_val_t alignment,
+                              const std::nothrow_t& tag) noexcept {
+    ::operator delete(p, alignment, tag);
+  }
+#endif  // __cpp_aligned_new
+
   // Basic Operations ------------------------------------------------
 
   // Get the name of this message type, e.g. "foo.bar.BazProto".
@@ -408,6 +451,12 @@ class PROTOBUF_EXPORT MessageLite {
   bool AppendToCord(absl::Cord* output) const;
   // Like AppendToCord(), but allows missing required fields.
   bool AppendPartialToCord(absl::Cord* output) const;
+  // Like AppendPartialToCord(), but string and bytes fields too large to be
+  // copied into the current buffer are added to `output` as references to
+  // this message's storage instead of being copied. The message must not be
+  // modified or destroyed while `output`, or any Cord sharing its data, is
+  // alive.
+  bool AppendPartialToCordWithAliasing(absl::Cord* output) const;
 
   // Computes the serialized size of the message.  This recursively calls
   // ByteSizeLong() on all embedded messages.
@@ -475,6 +475,8 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
   struct Data {
     const DescriptorPool* pool = nullptr;
     MessageFactory* factory = nullptr;
+    // See io::CodedInputStream::SetLazyMessageSetItems().
+    bool lazy_message_set_items = false;
   };
 
   template <typename... T>
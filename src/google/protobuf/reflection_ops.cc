@@ -90,19 +90,56 @@ void ReflectionOps::Merge(const Message& from, Message* to) {
   from_reflection->ListFields(from, &fields);
   for (const FieldDescriptor* field : fields) {
     if (field->is_repeated()) {
-      // Use map reflection if both are in map status and have the
-      // same map type to avoid sync with repeated field.
+      // Use map reflection if the destination is in map status to avoid
+      // sync with repeated field. If the source is also in map status and
+      // has the same map type, the maps are merged directly.
       // Note: As from and to messages have the same descriptor, the
       // map field types are the same if they are both generated
       // messages or both dynamic messages.
-      if (is_from_generated == is_to_generated && field->is_map()) {
+      if (field->is_map() &&
+          to_reflection->MutableMapData(to, field)->IsMapValid()) {
         const MapFieldBase* from_field =
             from_reflection->GetMapData(from, field);
-        MapFieldBase* to_field = to_reflection->MutableMapData(to, field);
-        if (to_field->IsMapValid() && from_field->IsMapValid()) {
-          to_field->MergeFrom(*from_field);
+        if (is_from_generated == is_to_generated && from_field->IsMapValid()) {
+          to_reflection->MutableMapData(to, field)->MergeFrom(*from_field);
           continue;
         }
+        // Otherwise merge entry by entry through the map API, so that neither
+        // map needs to be synced to its repeated field.
+        MapIterator end =
+            from_reflection->MapEnd(const_cast<Message*>(&from), field);
+        for (MapIterator it =
+                 from_reflection->MapBegin(const_cast<Message*>(&from), field);
+             it != end; ++it) {
+          const MapValueRef& from_value = it.GetValueRef();
+          MapValueRef to_value;
+          to_reflection->InsertOrLookupMapValue(to, field, it.GetKey(),
+                                                &to_value);
+          switch (field->message_type()->map_value()->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, METHOD)                              \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                        \
+    to_value.Set##METHOD##Value(from_value.Get##METHOD##Value()); \
+    break;
+
+            HANDLE_TYPE(INT32, Int32);
+            HANDLE_TYPE(INT64, Int64);
+            HANDLE_TYPE(UINT32, UInt32);
+            HANDLE_TYPE(UINT64, UInt64);
+            HANDLE_TYPE(FLOAT, Float);
+            HANDLE_TYPE(DOUBLE, Double);
+            HANDLE_TYPE(BOOL, Bool);
+            HANDLE_TYPE(STRING, String);
+            HANDLE_TYPE(ENUM, Enum);
+#undef HANDLE_TYPE
+
+            case FieldDescriptor::CPPTYPE_MESSAGE:
+              // A merged map entry replaces the existing value.
+              to_value.MutableMessageValue()->CopyFrom(
+                  from_value.GetMessageValue());
+              break;
+          }
+        }
+        continue;
       }
       int count = from_reflection->FieldSize(from, field);
       for (int j = 0; j < count; j++) {
@@ -181,68 +218,70 @@ void ReflectionOps::Merge(const Message& from, Message* to) {
 void ReflectionOps::Clear(Message* message) {
   const Reflection* reflection = GetReflectionOrDie(*message);
 
-  std::vector<const FieldDescriptor*> fields;
-  reflection->ListFields(*message, &fields);
-  for (const FieldDescriptor* field : fields) {
+  reflection->ForEachSetField(*message, [&](const FieldDescriptor* field) {
     reflection->ClearField(message, field);
-  }
+  });
 
   if (reflection->GetInternalMetadata(*message).have_unknown_fields()) {
     reflection->MutableUnknownFields(message)->Clear();
   }
 }
 
+bool ReflectionOps::MayBeUninitialized(const Message& message) {
+  const Reflection::InitializationFields& fields =
+      GetReflectionOrDie(message)->GetInitializationFields();
+  // Extensions may have required fields.
+  return !fields.required.empty() || !fields.messages.empty() ||
+         message.GetDescriptor()->extension_range_count() > 0;
+}
+
 bool ReflectionOps::IsInitialized(const Message& message, bool check_fields,
                                   bool check_descendants) {
   const Descriptor* descriptor = message.GetDescriptor();
   const Reflection* reflection = GetReflectionOrDie(message);
-  if (const int field_count = descriptor->field_count()) {
-    const FieldDescriptor* begin = descriptor->field(0);
-    const FieldDescriptor* end = begin + field_count;
-    ABSL_DCHECK_EQ(descriptor->field(field_count - 1), end - 1);
-
-    if (check_fields) {
-      // Check required fields of this message.
-      for (const FieldDescriptor* field = begin; field != end; ++field) {
-        if (field->is_required() && !reflection->HasField(message, field)) {
-          return false;
-        }
+  const Reflection::InitializationFields& fields =
+      reflection->GetInitializationFields();
+
+  if (check_fields) {
+    // Check required fields of this message.
+    for (const FieldDescriptor* field : fields.required) {
+      if (!reflection->HasField(message, field)) {
+        return false;
       }
     }
+  }
 
-    if (check_descendants) {
-      for (const FieldDescriptor* field = begin; field != end; ++field) {
-        if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
-          const Descriptor* message_type = field->message_type();
-          if (PROTOBUF_PREDICT_FALSE(message_type->options().map_entry())) {
-            if (message_type->field(1)->cpp_type() ==
-                FieldDescriptor::CPPTYPE_MESSAGE) {
-              const MapFieldBase* map_field =
-                  reflection->GetMapData(message, field);
-              if (map_field->IsMapValid()) {
-                MapIterator it(const_cast<Message*>(&message), field);
-                MapIterator end_map(const_cast<Message*>(&message), field);
-                for (map_field->MapBegin(&it), map_field->MapEnd(&end_map);
-                     it != end_map; ++it) {
-                  if (!it.GetValueRef().GetMessageValue().IsInitialized()) {
-                    return false;
-                  }
-                }
-              }
-            }
-          } else if (field->is_repeated()) {
-            const int size = reflection->FieldSize(message, field);
-            for (int j = 0; j < size; j++) {
-              if (!reflection->GetRepeatedMessage(message, field, j)
-                       .IsInitialized()) {
-                return false;
-              }
-            }
-          } else if (reflection->HasField(message, field)) {
-            if (!reflection->GetMessage(message, field).IsInitialized()) {
+  if (check_descendants) {
+    // Only message fields whose type may transitively contain required fields
+    // are listed, so subtrees that are always initialized are skipped.
+    for (const FieldDescriptor* field : fields.messages) {
+      if (PROTOBUF_PREDICT_FALSE(field->is_map())) {
+        // The map value must be a message, since only it can have required
+        // fields.
+        const MapFieldBase* map_field = reflection->GetMapData(message, field);
+        if (map_field->IsMapValid()) {
+          MapIterator it(const_cast<Message*>(&message), field);
+          MapIterator end_map(const_cast<Message*>(&message), field);
+          for (map_field->MapBegin(&it), map_field->MapEnd(&end_map);
+               it != end_map; ++it) {
+            if (!it.GetValueRef().GetMessageValue().IsInitialized()) {
               return false;
             }
           }
+          continue;
+        }
+      }
+      if (field->is_repeated()) {
+        const int size = reflection->FieldSize(message, field);
+        for (int j = 0; j < size; j++) {
+          if (!reflection->GetRepeatedMessage(message, field, j)
+                   .IsInitialized()) {
+            return false;
+          }
+        }
+      } else if (reflection->HasField(message, field)) {
+        if (!reflection->GetMessage(message, field).IsInitialized()) {
+          return false;
         }
       }
     }
@@ -266,68 +305,8 @@ bool ReflectionOps::IsInitialized(const Message& message, bool check_fields,
 }
 
 bool ReflectionOps::IsInitialized(const Message& message) {
-  const Descriptor* descriptor = message.GetDescriptor();
-  const Reflection* reflection = GetReflectionOrDie(message);
-
-  // Check required fields of this message.
-  {
-    const int field_count = descriptor->field_count();
-    for (int i = 0; i < field_count; i++) {
-      if (descriptor->field(i)->is_required()) {
-        if (!reflection->HasField(message, descriptor->field(i))) {
-          return false;
-        }
-      }
-    }
-  }
-
-  // Check that sub-messages are initialized.
-  std::vector<const FieldDescriptor*> fields;
-  // Should be safe to skip stripped fields because required fields are not
-  // stripped.
-  reflection->ListFields(message, &fields);
-  for (const FieldDescriptor* field : fields) {
-    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
-
-      if (field->is_map()) {
-        const FieldDescriptor* value_field = field->message_type()->field(1);
-        if (value_field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
-          const MapFieldBase* map_field =
-              reflection->GetMapData(message, field);
-          if (map_field->IsMapValid()) {
-            MapIterator iter(const_cast<Message*>(&message), field);
-            MapIterator end(const_cast<Message*>(&message), field);
-            for (map_field->MapBegin(&iter), map_field->MapEnd(&end);
-                 iter != end; ++iter) {
-              if (!iter.GetValueRef().GetMessageValue().IsInitialized()) {
-                return false;
-              }
-            }
-            continue;
-          }
-        } else {
-          continue;
-        }
-      }
-
-      if (field->is_repeated()) {
-        int size = reflection->FieldSize(message, field);
-
-        for (int j = 0; j < size; j++) {
-          if (!reflection->GetRepeatedMessage(message, field, j)
-                   .IsInitialized()) {
-            return false;
-          }
-        }
-      } else {
-        if (!reflection->GetMessage(message, field).IsInitialized()) {
-          return false;
-        }
-      }
-    }
-  }
-
-  return true;
+  return IsInitialized(message, /*check_fields=*/true,
+                       /*check_descendants=*/true);
 }
 
 static bool IsMapValueMessageTyped(const FieldDescriptor* map_field) {
@@ -342,12 +321,10 @@ void ReflectionOps::DiscardUnknownFields(Message* message) {
 
   // Walk through the fields of this message and DiscardUnknownFields on any
   // messages present.
-  std::vector<const FieldDescriptor*> fields;
-  reflection->ListFields(*message, &fields);
-  for (const FieldDescriptor* field : fields) {
+  reflection->ForEachSetField(*message, [&](const FieldDescriptor* field) {
     // Skip over non-message fields.
     if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
-      continue;
+      return;
     }
     // Discard the unknown fields in maps that contain message values.
     if (field->is_map() && IsMapValueMessageTyped(field)) {
@@ -372,7 +349,7 @@ void ReflectionOps::DiscardUnknownFields(Message* message) {
     } else {
       reflection->MutableMessage(message, field)->DiscardUnknownFields();
     }
-  }
+  });
 }
 
 static std::string SubMessagePrefix(const std::string& prefix,
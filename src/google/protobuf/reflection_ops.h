@@ -73,6 +73,11 @@ class PROTOBUF_EXPORT ReflectionOps {
                             bool check_descendants);
   static void DiscardUnknownFields(Message* message);
 
+  // Returns false if every message of the given message's type is
+  // initialized, i.e. neither it nor anything reachable from it can have
+  // required fields. Computed once per type.
+  static bool MayBeUninitialized(const Message& message);
+
   // Finds all unset required fields in the message and adds their full
   // paths (e.g. "foo.bar[5].baz") to *names.  "prefix" will be attached to
   // the front of each name.
@@ -390,6 +390,36 @@ TEST(ReflectionOpsTest, ForeignIsInitialized) {
   EXPECT_TRUE(ReflectionOps::IsInitialized(message, false, true));
 }
 
+TEST(ReflectionOpsTest, TransitiveIsInitialized) {
+  // Recursive types without required fields are always initialized.
+  unittest::TestRecursiveMessage recursive;
+  recursive.mutable_a()->mutable_a()->mutable_a()->set_i(1);
+  EXPECT_TRUE(ReflectionOps::IsInitialized(recursive));
+
+  // Required fields are still found deep inside a recursive type.
+  unittest::TestNestedRequiredForeign message;
+  unittest::TestNestedRequiredForeign* leaf =
+      message.mutable_child()->mutable_child()->mutable_child();
+  leaf->set_dummy(1);
+  EXPECT_TRUE(ReflectionOps::IsInitialized(message));
+
+  leaf->mutable_payload()->mutable_optional_message()->set_a(1);
+  EXPECT_FALSE(ReflectionOps::IsInitialized(message));
+  EXPECT_TRUE(ReflectionOps::IsInitialized(message, true, false));
+
+  leaf->mutable_payload()->mutable_optional_message()->set_b(2);
+  leaf->mutable_payload()->mutable_optional_message()->set_c(3);
+  EXPECT_TRUE(ReflectionOps::IsInitialized(message));
+
+  // Required fields inside groups are found as well.
+  unittest::TestIsInitialized grouped;
+  EXPECT_TRUE(ReflectionOps::IsInitialized(grouped));
+  grouped.mutable_sub_message()->mutable_subgroup();
+  EXPECT_FALSE(ReflectionOps::IsInitialized(grouped));
+  grouped.mutable_sub_message()->mutable_subgroup()->set_i(1);
+  EXPECT_TRUE(ReflectionOps::IsInitialized(grouped));
+}
+
 TEST(ReflectionOpsTest, ExtensionIsInitialized) {
   unittest::TestAllExtensions message;
 
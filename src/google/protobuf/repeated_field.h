@@ -467,7 +467,7 @@ class RepeatedField final {
   void InternalDeallocate() {
     const size_t bytes = total_size_ * sizeof(Element) + kRepHeaderSize;
     if (rep()->arena == nullptr) {
-      internal::SizedDelete(rep(), bytes);
+      internal::DeallocateHeap(rep(), bytes);
     } else if (!in_destructor) {
       // If we are in the destructor, we might be being destroyed as part of
       // the arena teardown. We can't try and return blocks to the arena then.
@@ -960,7 +960,7 @@ PROTOBUF_NOINLINE void RepeatedField<Element>::GrowNoAnnotate(int current_size,
     ABSL_DCHECK_LE((bytes - kRepHeaderSize) / sizeof(Element),
                    static_cast<size_t>(std::numeric_limits<int>::max()))
         << "Requested size is too large to fit element count into int.";
-    internal::SizedPtr res = internal::AllocateAtLeast(bytes);
+    internal::SizedPtr res = internal::AllocateHeapAtLeast(bytes);
     size_t num_available =
         std::min((res.n - kRepHeaderSize) / sizeof(Element),
                  static_cast<size_t>(std::numeric_limits<int>::max()));
@@ -65,7 +65,7 @@ void** RepeatedPtrFieldBase::InternalExtend(int extend_amount) {
       << "Requested size is too large to fit into size_t.";
   size_t bytes = kRepHeaderSize + sizeof(old_rep->elements[0]) * new_size;
   if (arena == nullptr) {
-    internal::SizedPtr res = internal::AllocateAtLeast(bytes);
+    internal::SizedPtr res = internal::AllocateHeapAtLeast(bytes);
     new_size = (res.n - kRepHeaderSize) / sizeof(old_rep->elements[0]);
     rep_ = reinterpret_cast<Rep*>(res.p);
   } else {
@@ -83,7 +83,7 @@ void** RepeatedPtrFieldBase::InternalExtend(int extend_amount) {
     const size_t old_size =
         old_total_size * sizeof(rep_->elements[0]) + kRepHeaderSize;
     if (arena == nullptr) {
-      internal::SizedDelete(old_rep, old_size);
+      internal::DeallocateHeap(old_rep, old_size);
     } else {
       arena_->ReturnArrayMemory(old_rep, old_size);
     }
@@ -108,7 +108,7 @@ void RepeatedPtrFieldBase::DestroyProtos() {
     delete static_cast<MessageLite*>(elements[i]);
   }
   const size_t size = total_size_ * sizeof(elements[0]) + kRepHeaderSize;
-  internal::SizedDelete(rep_, size);
+  internal::DeallocateHeap(rep_, size);
   rep_ = nullptr;
 }
 
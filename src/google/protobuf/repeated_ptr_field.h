@@ -253,7 +253,7 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
         TypeHandler::Delete(cast<TypeHandler>(elements[i]), nullptr);
       }
       const size_t size = total_size_ * sizeof(elements[0]) + kRepHeaderSize;
-      internal::SizedDelete(rep_, size);
+      internal::DeallocateHeap(rep_, size);
     }
     rep_ = nullptr;
   }
@@ -422,6 +422,28 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
     return allocated_bytes;
   }
 
+  // Like SpaceUsedExcludingSelfLong(), but measures at most `max_samples`
+  // evenly spaced allocated elements (cleared ones included) with
+  // `space_used` and extrapolates from their average.
+  template <typename TypeHandler, typename SpaceUsed>
+  size_t EstimateSpaceUsedExcludingSelfLong(int max_samples,
+                                            SpaceUsed space_used) const {
+    size_t allocated_bytes = static_cast<size_t>(total_size_) * sizeof(void*);
+    if (rep_ != nullptr) {
+      const int allocated = rep_->allocated_size;
+      const int samples = std::min(allocated, max_samples);
+      size_t sampled_bytes = 0;
+      for (int i = 0; i < samples; ++i) {
+        const int index =
+            static_cast<int>(static_cast<int64_t>(i) * allocated / samples);
+        sampled_bytes += space_used(*cast<TypeHandler>(rep_->elements[index]));
+      }
+      if (samples > 0) allocated_bytes += sampled_bytes * allocated / samples;
+      allocated_bytes += kRepHeaderSize;
+    }
+    return allocated_bytes;
+  }
+
   // Advanced memory management --------------------------------------
 
   // Like Add(), but if there are no cleared objects to use, returns nullptr.
@@ -42,6 +42,7 @@
 #include <climits>
 #include <cmath>
 #include <limits>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -2366,21 +2367,26 @@ class MapFieldPrinterHelper {
  public:
   // DynamicMapSorter::Sort cannot be used because it enforces syncing with
   // repeated field.
-  static bool SortMap(const Message& message, const Reflection* reflection,
-                      const FieldDescriptor* field,
-                      std::vector<const Message*>* sorted_map_field);
+  //
+  // If the repeated field is in sync, its entries are stored in
+  // *sorted_map_field. Otherwise the map's keys and values are stored in
+  // *sorted_map_entries, without building an entry message for each of them.
+  static void SortMap(
+      const Message& message, const Reflection* reflection,
+      const FieldDescriptor* field,
+      std::vector<const Message*>* sorted_map_field,
+      std::vector<std::pair<MapKey, MapValueRef>>* sorted_map_entries);
   static void CopyKey(const MapKey& key, Message* message,
                       const FieldDescriptor* field_desc);
   static void CopyValue(const MapValueRef& value, Message* message,
                         const FieldDescriptor* field_desc);
 };
 
-// Returns true if elements contained in sorted_map_field need to be released.
-bool MapFieldPrinterHelper::SortMap(
+void MapFieldPrinterHelper::SortMap(
     const Message& message, const Reflection* reflection,
     const FieldDescriptor* field,
-    std::vector<const Message*>* sorted_map_field) {
-  bool need_release = false;
+    std::vector<const Message*>* sorted_map_field,
+    std::vector<std::pair<MapKey, MapValueRef>>* sorted_map_entries) {
   const MapFieldBase& base = *reflection->GetMapData(message, field);
 
   if (base.IsRepeatedFieldValid()) {
@@ -2390,29 +2396,24 @@ bool MapFieldPrinterHelper::SortMap(
       sorted_map_field->push_back(
           const_cast<RepeatedPtrField<Message>*>(&map_field)->Mutable(i));
     }
-  } else {
-    // TODO(teboring): For performance, instead of creating map entry message
-    // for each element, just store map keys and sort them.
-    const Descriptor* map_entry_desc = field->message_type();
-    const Message* prototype =
-        reflection->GetMessageFactory()->GetPrototype(map_entry_desc);
-    for (MapIterator iter =
-             reflection->MapBegin(const_cast<Message*>(&message), field);
-         iter != reflection->MapEnd(const_cast<Message*>(&message), field);
-         ++iter) {
-      Message* map_entry_message = prototype->New();
-      CopyKey(iter.GetKey(), map_entry_message, map_entry_desc->field(0));
-      CopyValue(iter.GetValueRef(), map_entry_message,
-                map_entry_desc->field(1));
-      sorted_map_field->push_back(map_entry_message);
-    }
-    need_release = true;
-  }
-
-  MapEntryMessageComparator comparator(field->message_type());
-  std::stable_sort(sorted_map_field->begin(), sorted_map_field->end(),
-                   comparator);
-  return need_release;
+    MapEntryMessageComparator comparator(field->message_type());
+    std::stable_sort(sorted_map_field->begin(), sorted_map_field->end(),
+                     comparator);
+    return;
+  }
+
+  // The values are referenced in place; only the keys are copied.
+  MapIterator end = reflection->MapEnd(const_cast<Message*>(&message), field);
+  for (MapIterator iter =
+           reflection->MapBegin(const_cast<Message*>(&message), field);
+       iter != end; ++iter) {
+    sorted_map_entries->emplace_back(iter.GetKey(), iter.GetValueRef());
+  }
+  std::sort(sorted_map_entries->begin(), sorted_map_entries->end(),
+            [](const std::pair<MapKey, MapValueRef>& a,
+               const std::pair<MapKey, MapValueRef>& b) {
+              return a.first < b.first;
+            });
 }
 
 void MapFieldPrinterHelper::CopyKey(const MapKey& key, Message* message,
@@ -2460,12 +2461,10 @@ void MapFieldPrinterHelper::CopyValue(const MapValueRef& value,
     case FieldDescriptor::CPPTYPE_ENUM:
       reflection->SetEnumValue(message, field_desc, value.GetEnumValue());
       return;
-    case FieldDescriptor::CPPTYPE_MESSAGE: {
-      Message* sub_message = value.GetMessageValue().New();
-      sub_message->CopyFrom(value.GetMessageValue());
-      reflection->SetAllocatedMessage(message, sub_message, field_desc);
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      reflection->MutableMessage(message, field_desc)
+          ->CopyFrom(value.GetMessageValue());
       return;
-    }
     case FieldDescriptor::CPPTYPE_STRING:
       reflection->SetString(message, field_desc, value.GetStringValue());
       return;
@@ -2509,11 +2508,19 @@ void TextFormat::Printer::PrintField(const Message& message,
   }
 
   std::vector<const Message*> sorted_map_field;
-  bool need_release = false;
+  std::vector<std::pair<MapKey, MapValueRef>> sorted_map_entries;
+  // Holds the entry being printed when the map is printed from
+  // sorted_map_entries; reused for every entry.
+  std::unique_ptr<Message> map_entry;
   bool is_map = field->is_map();
   if (is_map) {
-    need_release = internal::MapFieldPrinterHelper::SortMap(
-        message, reflection, field, &sorted_map_field);
+    internal::MapFieldPrinterHelper::SortMap(
+        message, reflection, field, &sorted_map_field, &sorted_map_entries);
+    if (!sorted_map_entries.empty()) {
+      map_entry.reset(reflection->GetMessageFactory()
+                          ->GetPrototype(field->message_type())
+                          ->New());
+    }
   }
 
   for (int j = 0; j < count; ++j) {
@@ -2523,11 +2530,25 @@ void TextFormat::Printer::PrintField(const Message& message,
 
     if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
       const FastFieldValuePrinter* printer = GetFieldPrinter(field);
-      const Message& sub_message =
-          field->is_repeated()
-              ? (is_map ? *sorted_map_field[j]
-                        : reflection->GetRepeatedMessage(message, field, j))
-              : reflection->GetMessage(message, field);
+      const Message* sub_message_ptr;
+      if (map_entry != nullptr) {
+        const Descriptor* map_entry_desc = field->message_type();
+        map_entry->Clear();
+        internal::MapFieldPrinterHelper::CopyKey(
+            sorted_map_entries[j].first, map_entry.get(),
+            map_entry_desc->map_key());
+        internal::MapFieldPrinterHelper::CopyValue(
+            sorted_map_entries[j].second, map_entry.get(),
+            map_entry_desc->map_value());
+        sub_message_ptr = map_entry.get();
+      } else if (is_map) {
+        sub_message_ptr = sorted_map_field[j];
+      } else if (field->is_repeated()) {
+        sub_message_ptr = &reflection->GetRepeatedMessage(message, field, j);
+      } else {
+        sub_message_ptr = &reflection->GetMessage(message, field);
+      }
+      const Message& sub_message = *sub_message_ptr;
       printer->PrintMessageStart(sub_message, field_index, count,
                                  single_line_mode_, generator);
       generator->Indent();
@@ -2549,12 +2570,6 @@ void TextFormat::Printer::PrintField(const Message& message,
       }
     }
   }
-
-  if (need_release) {
-    for (const Message* message_to_delete : sorted_map_field) {
-      delete message_to_delete;
-    }
-  }
 }
 
 void TextFormat::Printer::PrintShortRepeatedField(
@@ -33,6 +33,7 @@
 
 #include "google/protobuf/util/delimited_message_util.h"
 
+#include "google/protobuf/io/checksumming_stream.h"
 #include "google/protobuf/io/coded_stream.h"
 
 namespace google {
@@ -124,6 +125,42 @@ bool SerializeDelimitedToCodedStream(const MessageLite& message,
   return true;
 }
 
+bool SerializeDelimitedWithChecksumToZeroCopyStream(
+    const MessageLite& message, io::ZeroCopyOutputStream* output) {
+  io::ChecksummingOutputStream checksummed_output(output);
+  {
+    io::CodedOutputStream coded_output(&checksummed_output);
+    if (!SerializeDelimitedToCodedStream(message, &coded_output)) return false;
+    coded_output.Trim();
+    if (coded_output.HadError()) return false;
+  }
+  // Take the checksum before `output` hands out another buffer, which may
+  // reuse or free the one the record ended in.
+  const uint32_t checksum = checksummed_output.Checksum();
+  io::CodedOutputStream coded_output(output);
+  coded_output.WriteLittleEndian32(checksum);
+  coded_output.Trim();
+  return !coded_output.HadError();
+}
+
+bool ParseDelimitedWithChecksumFromZeroCopyStream(
+    MessageLite* message, io::ZeroCopyInputStream* input, bool* clean_eof) {
+  io::ChecksummingInputStream checksummed_input(input);
+  {
+    // Destroying the CodedInputStream backs up the bytes it read past the
+    // record, which takes them out of the checksum again.
+    io::CodedInputStream coded_input(&checksummed_input);
+    if (!ParseDelimitedFromCodedStream(message, &coded_input, clean_eof)) {
+      return false;
+    }
+  }
+  // Take the checksum before `input` refills the buffer the record ended in.
+  const uint32_t expected = checksummed_input.Checksum();
+  io::CodedInputStream coded_input(input);
+  uint32_t checksum;
+  return coded_input.ReadLittleEndian32(&checksum) && checksum == expected;
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
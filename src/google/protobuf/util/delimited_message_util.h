@@ -99,6 +99,20 @@ bool PROTOBUF_EXPORT SerializeDelimitedToZeroCopyStream(
 bool PROTOBUF_EXPORT SerializeDelimitedToCodedStream(
     const MessageLite& message, io::CodedOutputStream* output);
 
+// Like SerializeDelimitedToZeroCopyStream(), but follows the message with the
+// CRC32C of the record so far (the size and the message bytes) as a
+// little-endian fixed32. The checksum is computed over the output buffers as
+// they are filled, without an intermediate copy of the message.
+bool PROTOBUF_EXPORT SerializeDelimitedWithChecksumToZeroCopyStream(
+    const MessageLite& message, io::ZeroCopyOutputStream* output);
+
+// Reads a record written by SerializeDelimitedWithChecksumToZeroCopyStream().
+// Returns false if the record cannot be read or its checksum does not match;
+// in the latter case |message| holds the data that was read. |clean_eof| is
+// as for ParseDelimitedFromZeroCopyStream().
+bool PROTOBUF_EXPORT ParseDelimitedWithChecksumFromZeroCopyStream(
+    MessageLite* message, io::ZeroCopyInputStream* input, bool* clean_eof);
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -111,6 +111,132 @@ TEST(DelimitedMessageUtilTest, FailsAtEndOfStream) {
   }
 }
 
+TEST(DelimitedMessageUtilTest, ChecksummedMessages) {
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    protobuf_unittest::TestAllTypes message1;
+    TestUtil::SetAllFields(&message1);
+    EXPECT_TRUE(SerializeDelimitedWithChecksumToZeroCopyStream(message1,
+                                                               &output));
+
+    protobuf_unittest::TestPackedTypes message2;
+    TestUtil::SetPackedFields(&message2);
+    EXPECT_TRUE(SerializeDelimitedWithChecksumToZeroCopyStream(message2,
+                                                               &output));
+  }
+
+  // Use a small block size so records span several buffers.
+  io::ArrayInputStream input(data.data(), data.size(), 7);
+  bool clean_eof = true;
+
+  protobuf_unittest::TestAllTypes message1;
+  EXPECT_TRUE(ParseDelimitedWithChecksumFromZeroCopyStream(&message1, &input,
+                                                           &clean_eof));
+  EXPECT_FALSE(clean_eof);
+  TestUtil::ExpectAllFieldsSet(message1);
+
+  protobuf_unittest::TestPackedTypes message2;
+  EXPECT_TRUE(ParseDelimitedWithChecksumFromZeroCopyStream(&message2, &input,
+                                                           &clean_eof));
+  EXPECT_FALSE(clean_eof);
+  TestUtil::ExpectPackedFieldsSet(message2);
+
+  EXPECT_FALSE(ParseDelimitedWithChecksumFromZeroCopyStream(&message2, &input,
+                                                            &clean_eof));
+  EXPECT_TRUE(clean_eof);
+}
+
+TEST(DelimitedMessageUtilTest, ChecksumDetectsCorruption) {
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    protobuf_unittest::ForeignMessage message;
+    message.set_c(42);
+    message.set_d(24);
+    EXPECT_TRUE(SerializeDelimitedWithChecksumToZeroCopyStream(message,
+                                                               &output));
+  }
+  // Size, two fields of two bytes each, and the checksum.
+  ASSERT_EQ(data.size(), 1 + 4 + 4);
+
+  {
+    io::ArrayInputStream input(data.data(), data.size());
+    protobuf_unittest::ForeignMessage message;
+    EXPECT_TRUE(ParseDelimitedWithChecksumFromZeroCopyStream(&message, &input,
+                                                             nullptr));
+    EXPECT_EQ(message.c(), 42);
+  }
+
+  // Changing a value still parses, but no longer matches the checksum.
+  data[2] = 43;
+  {
+    io::ArrayInputStream input(data.data(), data.size());
+    protobuf_unittest::ForeignMessage message;
+    EXPECT_FALSE(ParseDelimitedWithChecksumFromZeroCopyStream(&message, &input,
+                                                              nullptr));
+  }
+
+  // So does a missing checksum.
+  {
+    io::ArrayInputStream input(data.data(), data.size() - 4);
+    protobuf_unittest::ForeignMessage message;
+    EXPECT_FALSE(ParseDelimitedWithChecksumFromZeroCopyStream(&message, &input,
+                                                              nullptr));
+  }
+}
+
+TEST(DelimitedMessageUtilTest, ChecksummedRecordEndingAtBufferBoundary) {
+  // A string that grows when the record fills its capacity, so the trailer
+  // goes to a new allocation.
+  std::string data;
+  data.reserve(30);
+  protobuf_unittest::TestAllTypes message;
+  // Size varint, tag, length and payload fill the capacity exactly.
+  message.set_optional_bytes(std::string(data.capacity() - 3, 'x'));
+  ASSERT_EQ(message.ByteSizeLong() + 1, data.capacity());
+  {
+    io::StringOutputStream output(&data);
+    EXPECT_TRUE(SerializeDelimitedWithChecksumToZeroCopyStream(message,
+                                                               &output));
+  }
+  ASSERT_EQ(data.size(), message.ByteSizeLong() + 1 + 4);
+
+  // Read through a copying adaptor whose blocks end where the record does, so
+  // reading the trailer refills the buffer holding the record.
+  std::istringstream stream(data);
+  io::IstreamInputStream input(&stream,
+                               static_cast<int>(data.size() - 4));
+  protobuf_unittest::TestAllTypes parsed;
+  EXPECT_TRUE(
+      ParseDelimitedWithChecksumFromZeroCopyStream(&parsed, &input, nullptr));
+  EXPECT_EQ(parsed.optional_bytes(), message.optional_bytes());
+}
+
+TEST(DelimitedMessageUtilTest, ChecksummedRecordsAtEveryBlockSize) {
+  protobuf_unittest::ForeignMessage message;
+  message.set_c(42);
+  message.set_d(24);
+  for (int block_size = 1; block_size <= 20; ++block_size) {
+    std::stringstream stream;
+    {
+      io::OstreamOutputStream output(&stream, block_size);
+      EXPECT_TRUE(SerializeDelimitedWithChecksumToZeroCopyStream(message,
+                                                                 &output));
+      EXPECT_TRUE(SerializeDelimitedWithChecksumToZeroCopyStream(message,
+                                                                 &output));
+    }
+    io::IstreamInputStream input(&stream, block_size);
+    for (int i = 0; i < 2; ++i) {
+      protobuf_unittest::ForeignMessage parsed;
+      EXPECT_TRUE(ParseDelimitedWithChecksumFromZeroCopyStream(&parsed, &input,
+                                                               nullptr))
+          << "block_size " << block_size << ", record " << i;
+      EXPECT_EQ(parsed.d(), 24);
+    }
+  }
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -0,0 +1,162 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/field_mask_parser.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_check.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/generated_message_tctable_impl.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/parse_context.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+using internal::TcParser;
+using internal::TcParseTableBase;
+
+// A node of the mask tree. The children are the selected fields of the
+// message type the node stands for. A node with `all` set selects the whole
+// field; its children are then irrelevant and kept empty.
+struct FieldMaskParser::Node {
+  bool all = false;
+  absl::flat_hash_map<const FieldDescriptor*, std::unique_ptr<Node>> children;
+};
+
+FieldMaskParser::FieldMaskParser(const Message& prototype,
+                                 const FieldMask& mask, const Options& options)
+    : prototype_(prototype), options_(options), root_table_(nullptr) {
+  if (mask.paths().empty()) return;
+  Node root;
+  for (const std::string& path : mask.paths()) {
+    AddPath(prototype.GetDescriptor(), path, &root);
+  }
+  root_table_ = BuildTable(prototype, root);
+}
+
+FieldMaskParser::~FieldMaskParser() {
+  for (const TcParseTableBase* table : tables_) {
+    ::operator delete(const_cast<TcParseTableBase*>(table));
+  }
+}
+
+void FieldMaskParser::AddPath(const Descriptor* descriptor,
+                              absl::string_view path, Node* root) {
+  // Resolve the whole path first, so that invalid paths are ignored.
+  std::vector<const FieldDescriptor*> fields;
+  for (absl::string_view name : absl::StrSplit(path, '.')) {
+    if (descriptor == nullptr) return;
+    const FieldDescriptor* field = descriptor->FindFieldByName(name);
+    if (field == nullptr) return;
+    fields.push_back(field);
+    descriptor = field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+                         !field->is_map()
+                     ? field->message_type()
+                     : nullptr;
+  }
+
+  Node* node = root;
+  for (const FieldDescriptor* field : fields) {
+    // A prefix of the path is already selected as a whole.
+    if (node->all) return;
+    std::unique_ptr<Node>& child = node->children[field];
+    if (child == nullptr) child = absl::make_unique<Node>();
+    node = child.get();
+  }
+  node->all = true;
+  node->children.clear();
+}
+
+const TcParseTableBase* FieldMaskParser::BuildTable(const Message& prototype,
+                                                    const Node& node) {
+  const Reflection* reflection = prototype.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  absl::flat_hash_map<const FieldDescriptor*, const TcParseTableBase*>
+      sub_tables;
+  for (const auto& entry : node.children) {
+    const FieldDescriptor* field = entry.first;
+    fields.push_back(field);
+    if (!entry.second->all) {
+      const Message* sub_prototype =
+          reflection->GetMessageFactory()->GetPrototype(field->message_type());
+      sub_tables[field] = BuildTable(*sub_prototype, *entry.second);
+    }
+  }
+
+  const TcParseTableBase* table = reflection->CreateTcParseTable(
+      std::move(fields),
+      [&sub_tables](const FieldDescriptor* field) -> const TcParseTableBase* {
+        auto it = sub_tables.find(field);
+        return it == sub_tables.end() ? nullptr : it->second;
+      },
+      options_.keep_unknown_fields ? &TcParser::ProjectionFallbackKeepUnknown
+                                   : &TcParser::ProjectionFallback);
+  tables_.push_back(table);
+  return table;
+}
+
+bool FieldMaskParser::MergePartialFromString(absl::string_view data,
+                                             Message* message) const {
+  ABSL_CHECK_EQ(message->GetReflection(), prototype_.GetReflection())
+      << "Message of type " << message->GetTypeName()
+      << " does not match the prototype of type " << prototype_.GetTypeName();
+  const char* ptr;
+  internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
+                             /*aliasing=*/false, &ptr, data);
+  ptr = root_table_ == nullptr
+            ? message->_InternalParse(ptr, &ctx)
+            : TcParser::ParseLoop(message, ptr, &ctx, root_table_);
+  // ctx has an explicit limit set (length of string_view).
+  return ptr != nullptr && ctx.EndedAtLimit();
+}
+
+bool FieldMaskParser::ParsePartialFromString(absl::string_view data,
+                                             Message* message) const {
+  message->Clear();
+  return MergePartialFromString(data, message);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
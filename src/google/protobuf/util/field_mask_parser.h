@@ -0,0 +1,123 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Defines a parser that only decodes the fields selected by a FieldMask.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_FIELD_MASK_PARSER_H__
+#define GOOGLE_PROTOBUF_UTIL_FIELD_MASK_PARSER_H__
+
+#include <vector>
+
+#include "google/protobuf/field_mask.pb.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+struct TcParseTableBase;
+}  // namespace internal
+
+namespace util {
+
+// Parses serialized messages of one type while only decoding the fields
+// selected by a FieldMask. Fields outside the mask are skipped by their
+// length or wire type, and only the submessages named by the mask are
+// entered. The result is the same as parsing the whole message and then
+// calling FieldMaskUtil::TrimMessage(), without paying for the fields that
+// are thrown away.
+//
+// Usage:
+//   FieldMask mask;
+//   FieldMaskUtil::FromString("header.title,tags", &mask);
+//   FieldMaskParser parser(Document::default_instance(), mask);
+//   Document doc;
+//   if (parser.ParsePartialFromString(serialized, &doc)) { ... }
+//
+// The mask is compiled into parse tables once, when the parser is
+// constructed. Paths that do not name a field, and paths that go through a
+// map or a non-message field, are ignored. A path naming a map field selects
+// the whole map. As with TrimMessage(), a mask without any paths selects the
+// whole message. Required fields are not checked, since the mask may leave
+// them out.
+//
+// A FieldMaskParser may be used from several threads at once.
+class PROTOBUF_EXPORT FieldMaskParser {
+ public:
+  struct Options {
+    Options() {}
+    // If true, the fields outside the mask are kept as unknown fields of the
+    // message they occur in, so serializing the result gives back all of the
+    // input. Otherwise they are dropped.
+    bool keep_unknown_fields = false;
+  };
+
+  // Compiles `mask` for messages of the same type, and from the same factory,
+  // as `prototype`. `prototype` must outlive the parser.
+  FieldMaskParser(const Message& prototype, const FieldMask& mask,
+                  const Options& options = Options());
+  FieldMaskParser(const FieldMaskParser&) = delete;
+  FieldMaskParser& operator=(const FieldMaskParser&) = delete;
+  ~FieldMaskParser();
+
+  // Merges the masked fields of `data` into `message`. Returns false if `data`
+  // is not a valid serialized message.
+  bool MergePartialFromString(absl::string_view data, Message* message) const;
+
+  // Like MergePartialFromString(), but clears `message` first.
+  bool ParsePartialFromString(absl::string_view data, Message* message) const;
+
+ private:
+  // The mask as a tree of fields. See field_mask_parser.cc.
+  struct Node;
+  static void AddPath(const Descriptor* descriptor, absl::string_view path,
+                      Node* root);
+  const internal::TcParseTableBase* BuildTable(const Message& prototype,
+                                               const Node& node);
+
+  const Message& prototype_;
+  const Options options_;
+  // Null if the mask selects the whole message.
+  const internal::TcParseTableBase* root_table_;
+  // Every table built for the mask: one for the prototype's type and one for
+  // every submessage field the mask restricts further.
+  std::vector<const internal::TcParseTableBase*> tables_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_FIELD_MASK_PARSER_H__
@@ -0,0 +1,187 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/field_mask_parser.h"
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/util/field_mask_util.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using protobuf_unittest::NestedTestAllTypes;
+using protobuf_unittest::TestAllTypes;
+
+NestedTestAllTypes MakeNestedMessage() {
+  NestedTestAllTypes message;
+  TestUtil::SetAllFields(message.mutable_payload());
+  TestUtil::SetAllFields(message.mutable_child()->mutable_payload());
+  NestedTestAllTypes* grandchild = message.mutable_child()->mutable_child();
+  grandchild->mutable_payload()->set_optional_int32(7);
+  for (int i = 0; i < 3; ++i) {
+    NestedTestAllTypes* child = message.add_repeated_child();
+    TestUtil::SetAllFields(child->mutable_payload());
+    child->mutable_payload()->set_optional_int32(i);
+  }
+  return message;
+}
+
+FieldMask MakeMask(absl::string_view paths) {
+  FieldMask mask;
+  FieldMaskUtil::FromString(paths, &mask);
+  return mask;
+}
+
+// Parses `data` in full and then trims it to `mask`.
+std::string ParseAndTrim(const FieldMask& mask, const std::string& data) {
+  NestedTestAllTypes message;
+  EXPECT_TRUE(message.ParseFromString(data));
+  FieldMaskUtil::TrimMessage(mask, &message);
+  return message.DebugString();
+}
+
+TEST(FieldMaskParserTest, MatchesParseThenTrim) {
+  const std::string data = MakeNestedMessage().SerializeAsString();
+  for (absl::string_view paths :
+       {"", "payload", "payload.optional_int32,payload.repeated_string",
+        "child.payload.optional_nested_message,child.child",
+        "payload.optional_nested_message.bb,payload",
+        "payload.map_int32_int32,payload.oneof_bytes"}) {
+    SCOPED_TRACE(paths);
+    FieldMask mask = MakeMask(paths);
+    FieldMaskParser parser(NestedTestAllTypes::default_instance(), mask);
+    NestedTestAllTypes message;
+    ASSERT_TRUE(parser.ParsePartialFromString(data, &message));
+    EXPECT_EQ(ParseAndTrim(mask, data), message.DebugString());
+    EXPECT_TRUE(message.unknown_fields().empty());
+  }
+}
+
+TEST(FieldMaskParserTest, RepeatedSubmessages) {
+  const NestedTestAllTypes original = MakeNestedMessage();
+  FieldMaskParser parser(NestedTestAllTypes::default_instance(),
+                         MakeMask("repeated_child.payload.optional_int32"));
+  NestedTestAllTypes message;
+  ASSERT_TRUE(
+      parser.ParsePartialFromString(original.SerializeAsString(), &message));
+  EXPECT_FALSE(message.has_payload());
+  EXPECT_FALSE(message.has_child());
+  ASSERT_EQ(message.repeated_child_size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    NestedTestAllTypes expected;
+    expected.mutable_payload()->set_optional_int32(i);
+    EXPECT_EQ(expected.DebugString(), message.repeated_child(i).DebugString());
+  }
+}
+
+TEST(FieldMaskParserTest, DynamicMessage) {
+  const std::string data = MakeNestedMessage().SerializeAsString();
+  FieldMask mask = MakeMask("payload.optional_string,child.payload");
+
+  DynamicMessageFactory factory;
+  const Message* prototype =
+      factory.GetPrototype(NestedTestAllTypes::descriptor());
+  FieldMaskParser parser(*prototype, mask);
+  std::unique_ptr<Message> message(prototype->New());
+  ASSERT_TRUE(parser.ParsePartialFromString(data, message.get()));
+  EXPECT_EQ(ParseAndTrim(mask, data), message->DebugString());
+}
+
+TEST(FieldMaskParserTest, KeepsUnknownFields) {
+  const NestedTestAllTypes original = MakeNestedMessage();
+  const std::string data = original.SerializeAsString();
+  FieldMask mask = MakeMask("payload.optional_int32,repeated_child.payload");
+  FieldMaskParser::Options options;
+  options.keep_unknown_fields = true;
+  FieldMaskParser parser(NestedTestAllTypes::default_instance(), mask,
+                         options);
+
+  NestedTestAllTypes message;
+  ASSERT_TRUE(parser.ParsePartialFromString(data, &message));
+  EXPECT_EQ(message.payload().optional_int32(),
+            original.payload().optional_int32());
+  EXPECT_FALSE(message.payload().has_optional_int64());
+  EXPECT_FALSE(message.payload().unknown_fields().empty());
+  EXPECT_FALSE(message.unknown_fields().empty());
+
+  // Nothing is lost: reparsing the result gives back the original.
+  NestedTestAllTypes reparsed;
+  ASSERT_TRUE(reparsed.ParseFromString(message.SerializeAsString()));
+  EXPECT_EQ(original.DebugString(), reparsed.DebugString());
+}
+
+TEST(FieldMaskParserTest, IgnoresInvalidPaths) {
+  const std::string data = MakeNestedMessage().SerializeAsString();
+  FieldMaskParser parser(
+      NestedTestAllTypes::default_instance(),
+      MakeMask("payload.optional_int32,no_such_field,"
+               "payload.optional_int32.bad,payload.map_int32_int32.key"));
+  NestedTestAllTypes message;
+  ASSERT_TRUE(parser.ParsePartialFromString(data, &message));
+  EXPECT_EQ(ParseAndTrim(MakeMask("payload.optional_int32"), data),
+            message.DebugString());
+}
+
+TEST(FieldMaskParserTest, MergesAndRejectsInvalidInput) {
+  FieldMaskParser parser(TestAllTypes::default_instance(),
+                         MakeMask("optional_int32,repeated_int32"));
+  TestAllTypes input;
+  input.set_optional_int32(1);
+  input.add_repeated_int32(2);
+  input.set_optional_string("skipped");
+  const std::string data = input.SerializeAsString();
+
+  TestAllTypes message;
+  message.set_optional_int64(5);
+  ASSERT_TRUE(parser.MergePartialFromString(data, &message));
+  ASSERT_TRUE(parser.MergePartialFromString(data, &message));
+  EXPECT_EQ(message.optional_int32(), 1);
+  EXPECT_EQ(message.optional_int64(), 5);
+  EXPECT_EQ(message.repeated_int32_size(), 2);
+  EXPECT_FALSE(message.has_optional_string());
+
+  // Even skipped fields must be well formed.
+  EXPECT_FALSE(parser.ParsePartialFromString(
+      data.substr(0, data.size() - 1), &message));
+  EXPECT_FALSE(parser.ParsePartialFromString("\x08", &message));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -1117,15 +1117,11 @@ bool MessageDifferencer::CompareMapField(
     std::vector<SpecificField>* parent_fields) {
   ABSL_DCHECK(repeated_field->is_map());
 
-  // the input FieldDescriptor is guaranteed to be repeated field.
-  const Reflection* reflection1 = message1.GetReflection();
-  const Reflection* reflection2 = message2.GetReflection();
-
-  // When both map fields are on map, do not sync to repeated field.
-  if (reflection1->GetMapData(message1, repeated_field)->IsMapValid() &&
-      reflection2->GetMapData(message2, repeated_field)->IsMapValid() &&
-      // TODO(jieluo): Add support for reporter
-      reporter_ == nullptr &&
+  // Compare through map reflection so that neither map is synced to its
+  // repeated field. A map modified through the repeated field is brought up
+  // to date by the map accessors.
+  // TODO(jieluo): Add support for reporter
+  if (reporter_ == nullptr &&
       // Users didn't set custom map field key comparator
       map_field_key_comparator_.find(repeated_field) ==
           map_field_key_comparator_.end() &&
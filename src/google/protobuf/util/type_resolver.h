@@ -33,10 +33,14 @@
 #ifndef GOOGLE_PROTOBUF_UTIL_TYPE_RESOLVER_H__
 #define GOOGLE_PROTOBUF_UTIL_TYPE_RESOLVER_H__
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 
 #include "google/protobuf/type.pb.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "google/protobuf/port.h"
 
 
@@ -65,6 +69,32 @@ class PROTOBUF_EXPORT TypeResolver {
   // Resolves a type url for an enum type.
   virtual absl::Status ResolveEnumType(const std::string& type_url,
                                        google::protobuf::Enum* enum_type) = 0;
+
+  // Like ResolveMessageType(), but returns a shared, immutable Type, so that
+  // resolvers which keep their results around can hand them out without
+  // copying. The default implementation resolves a new Type every time.
+  virtual absl::StatusOr<std::shared_ptr<const google::protobuf::Type>>
+  FindMessageType(const std::string& type_url) {
+    auto type = std::make_shared<google::protobuf::Type>();
+    absl::Status status = ResolveMessageType(type_url, type.get());
+    if (!status.ok()) return status;
+    return std::shared_ptr<const google::protobuf::Type>(std::move(type));
+  }
+
+  // Like ResolveEnumType(), but returns a shared, immutable Enum.
+  virtual absl::StatusOr<std::shared_ptr<const google::protobuf::Enum>>
+  FindEnumType(const std::string& type_url) {
+    auto enum_type = std::make_shared<google::protobuf::Enum>();
+    absl::Status status = ResolveEnumType(type_url, enum_type.get());
+    if (!status.ok()) return status;
+    return std::shared_ptr<const google::protobuf::Enum>(std::move(enum_type));
+  }
+
+  // Returns a nonzero token if every type url will keep resolving to the same
+  // type until the token changes, or 0 if the resolver makes no such promise
+  // (the default). A token is never reused, not even by another resolver, so
+  // callers may keep data derived from resolved types keyed by it.
+  virtual uint64_t ResolutionToken() const { return 0; }
 };
 
 }  // namespace util
@@ -30,19 +30,27 @@
 
 #include "google/protobuf/util/type_resolver_util.h"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/source_context.pb.h"
 #include "google/protobuf/type.pb.h"
 #include "google/protobuf/wrappers.pb.h"
 #include "google/protobuf/descriptor.pb.h"
+#include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/descriptor_legacy.h"
 #include "google/protobuf/io/strtod.h"
 #include "google/protobuf/util/type_resolver.h"
@@ -383,6 +391,116 @@ TypeResolver* NewTypeResolverForDescriptorPool(absl::string_view url_prefix,
   return new DescriptorPoolTypeResolver(url_prefix, pool);
 }
 
+namespace {
+
+// Shared implementation of the CachingTypeResolver lookups; T is either Type
+// or Enum.
+template <typename T, typename Resolve>
+absl::StatusOr<std::shared_ptr<const T>> FindCached(
+    absl::Mutex& mutex,
+    absl::flat_hash_map<std::string, std::shared_ptr<const T>>& cache,
+    const uint64_t& token, size_t max_entries, std::atomic<uint64_t>& hits,
+    std::atomic<uint64_t>& misses, const std::string& type_url,
+    Resolve resolve) {
+  uint64_t lookup_token;
+  {
+    absl::ReaderMutexLock lock(&mutex);
+    auto it = cache.find(type_url);
+    if (it != cache.end()) {
+      hits.fetch_add(1, std::memory_order_relaxed);
+      return it->second;
+    }
+    lookup_token = token;
+  }
+
+  misses.fetch_add(1, std::memory_order_relaxed);
+  auto resolved = std::make_shared<T>();
+  absl::Status status = resolve(*resolved);
+  if (!status.ok()) return status;
+
+  absl::MutexLock lock(&mutex);
+  // Don't let a lookup that started before Clear() refill the cache with a
+  // result from before it.
+  if (token != lookup_token) {
+    return std::shared_ptr<const T>(std::move(resolved));
+  }
+  if (cache.size() >= max_entries) cache.clear();
+  // Another thread may have raced us here; hand out whichever copy won so
+  // that all callers share it.
+  return cache.try_emplace(type_url, std::move(resolved)).first->second;
+}
+
+// Tokens are drawn from a single process-wide sequence so that they are
+// never reused, not even by a resolver that lives at a freed one's address.
+uint64_t NextResolutionToken() {
+  static std::atomic<uint64_t> next{1};
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+CachingTypeResolver::CachingTypeResolver(TypeResolver* delegate,
+                                         size_t max_entries)
+    : delegate_(delegate),
+      max_entries_(max_entries),
+      token_(NextResolutionToken()) {
+  ABSL_CHECK(delegate_ != nullptr);
+  ABSL_CHECK_GT(max_entries_, 0u);
+}
+
+CachingTypeResolver::~CachingTypeResolver() = default;
+
+absl::Status CachingTypeResolver::ResolveMessageType(const std::string& type_url,
+                                                     Type* message_type) {
+  auto type = FindMessageType(type_url);
+  if (!type.ok()) return type.status();
+  *message_type = **type;
+  return absl::OkStatus();
+}
+
+absl::Status CachingTypeResolver::ResolveEnumType(const std::string& type_url,
+                                                  Enum* enum_type) {
+  auto type = FindEnumType(type_url);
+  if (!type.ok()) return type.status();
+  *enum_type = **type;
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::shared_ptr<const Type>>
+CachingTypeResolver::FindMessageType(const std::string& type_url) {
+  return FindCached(mutex_, types_, token_, max_entries_, hits_, misses_,
+                    type_url, [&](Type& type) {
+                      return delegate_->ResolveMessageType(type_url, &type);
+                    });
+}
+
+absl::StatusOr<std::shared_ptr<const Enum>> CachingTypeResolver::FindEnumType(
+    const std::string& type_url) {
+  return FindCached(mutex_, enums_, token_, max_entries_, hits_, misses_,
+                    type_url, [&](Enum& type) {
+                      return delegate_->ResolveEnumType(type_url, &type);
+                    });
+}
+
+uint64_t CachingTypeResolver::ResolutionToken() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return token_;
+}
+
+CachingTypeResolver::Stats CachingTypeResolver::stats() const {
+  Stats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void CachingTypeResolver::Clear() {
+  absl::MutexLock lock(&mutex_);
+  types_.clear();
+  enums_.clear();
+  token_ = NextResolutionToken();
+}
+
 // Performs a direct conversion from a descriptor to a type proto.
 Type ConvertDescriptorToType(absl::string_view url_prefix,
                              const Descriptor& descriptor) {
@@ -33,9 +33,21 @@
 #ifndef GOOGLE_PROTOBUF_UTIL_TYPE_RESOLVER_UTIL_H__
 #define GOOGLE_PROTOBUF_UTIL_TYPE_RESOLVER_UTIL_H__
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include "google/protobuf/type.pb.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/util/type_resolver.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -44,7 +56,6 @@ namespace google {
 namespace protobuf {
 class DescriptorPool;
 namespace util {
-class TypeResolver;
 
 // Creates a TypeResolver that serves type information in the given descriptor
 // pool. Caller takes ownership of the returned TypeResolver.
@@ -59,6 +70,65 @@ PROTOBUF_EXPORT google::protobuf::Type ConvertDescriptorToType(
 PROTOBUF_EXPORT google::protobuf::Enum ConvertDescriptorToType(
     const EnumDescriptor& descriptor);
 
+// A TypeResolver that remembers the results of another TypeResolver, keyed by
+// type URL, so that repeated conversions (e.g. every BinaryToJsonString() call
+// in a long-running server) do not rebuild the same Type protos over and over.
+// Only successful resolutions are cached.
+//
+// The cache is thread-safe: lookups that hit only take a shared lock. At most
+// max_entries messages and max_entries enums are kept; when a table fills up
+// it is dropped wholesale and refilled from the delegate.
+//
+// Does not take ownership of the delegate, which must outlive this object.
+class PROTOBUF_EXPORT CachingTypeResolver : public TypeResolver {
+ public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+  };
+
+  explicit CachingTypeResolver(TypeResolver* delegate,
+                               size_t max_entries = 1024);
+  ~CachingTypeResolver() override;
+
+  absl::Status ResolveMessageType(const std::string& type_url,
+                                  google::protobuf::Type* message_type) override;
+  absl::Status ResolveEnumType(const std::string& type_url,
+                               google::protobuf::Enum* enum_type) override;
+
+  // Return the cached Type or Enum itself; it stays valid after it has been
+  // evicted or Clear() has been called.
+  absl::StatusOr<std::shared_ptr<const google::protobuf::Type>> FindMessageType(
+      const std::string& type_url) override;
+  absl::StatusOr<std::shared_ptr<const google::protobuf::Enum>> FindEnumType(
+      const std::string& type_url) override;
+
+  // Changes whenever Clear() is called.
+  uint64_t ResolutionToken() const override;
+
+  // Returns the number of lookups served from the cache and forwarded to the
+  // delegate so far.
+  Stats stats() const;
+
+  // Forgets everything cached so far, e.g. after the delegate's underlying
+  // pool has changed.
+  void Clear();
+
+ private:
+  TypeResolver* const delegate_;
+  const size_t max_entries_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::shared_ptr<const google::protobuf::Type>>
+      types_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, std::shared_ptr<const google::protobuf::Enum>>
+      enums_ ABSL_GUARDED_BY(mutex_);
+  uint64_t token_ ABSL_GUARDED_BY(mutex_);
+
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -46,6 +46,7 @@
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor_legacy.h"
 #include "google/protobuf/util/json_format_proto3.pb.h"
+#include "google/protobuf/util/json_util.h"
 #include "google/protobuf/map_unittest.pb.h"
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/unittest_custom_options.pb.h"
@@ -695,6 +696,123 @@ TEST(ConvertDescriptorToTypeTest, TestCustomEnumOptions) {
       HasInt32Option(value->options(), "protobuf_unittest.enum_value_opt1", 123));
 }
 
+TEST(CachingTypeResolverTest, CachesMessagesAndEnums) {
+  std::unique_ptr<TypeResolver> delegate(NewTypeResolverForDescriptorPool(
+      kUrlPrefix, DescriptorPool::generated_pool()));
+  CachingTypeResolver resolver(delegate.get());
+
+  const std::string message_url = GetTypeUrl<protobuf_unittest::TestAllTypes>();
+  Type first, second;
+  ASSERT_TRUE(resolver.ResolveMessageType(message_url, &first).ok());
+  ASSERT_TRUE(resolver.ResolveMessageType(message_url, &second).ok());
+  EXPECT_EQ(first.SerializeAsString(), second.SerializeAsString());
+  EXPECT_EQ("protobuf_unittest.TestAllTypes", second.name());
+
+  const std::string enum_url = GetTypeUrl(
+      protobuf_unittest::TestAllTypes::NestedEnum_descriptor()->full_name());
+  Enum enum_type;
+  ASSERT_TRUE(resolver.ResolveEnumType(enum_url, &enum_type).ok());
+  ASSERT_TRUE(resolver.ResolveEnumType(enum_url, &enum_type).ok());
+  EXPECT_TRUE(EnumHasValue(enum_type, "FOO", 1));
+
+  EXPECT_EQ(2u, resolver.stats().hits);
+  EXPECT_EQ(2u, resolver.stats().misses);
+
+  resolver.Clear();
+  ASSERT_TRUE(resolver.ResolveMessageType(message_url, &first).ok());
+  EXPECT_EQ(3u, resolver.stats().misses);
+}
+
+TEST(CachingTypeResolverTest, DoesNotCacheErrors) {
+  std::unique_ptr<TypeResolver> delegate(NewTypeResolverForDescriptorPool(
+      kUrlPrefix, DescriptorPool::generated_pool()));
+  CachingTypeResolver resolver(delegate.get());
+
+  Type type;
+  EXPECT_FALSE(
+      resolver.ResolveMessageType(GetTypeUrl("no.such.Type"), &type).ok());
+  EXPECT_FALSE(
+      resolver.ResolveMessageType(GetTypeUrl("no.such.Type"), &type).ok());
+  EXPECT_EQ(0u, resolver.stats().hits);
+  EXPECT_EQ(2u, resolver.stats().misses);
+}
+
+TEST(CachingTypeResolverTest, IsBounded) {
+  std::unique_ptr<TypeResolver> delegate(NewTypeResolverForDescriptorPool(
+      kUrlPrefix, DescriptorPool::generated_pool()));
+  CachingTypeResolver resolver(delegate.get(), /*max_entries=*/1);
+
+  const std::string foo = GetTypeUrl<protobuf_unittest::TestAllTypes>();
+  const std::string bar = GetTypeUrl<protobuf_unittest::TestPackedTypes>();
+  Type type;
+  ASSERT_TRUE(resolver.ResolveMessageType(foo, &type).ok());
+  ASSERT_TRUE(resolver.ResolveMessageType(bar, &type).ok());
+  // Caching bar evicted foo.
+  ASSERT_TRUE(resolver.ResolveMessageType(foo, &type).ok());
+  EXPECT_EQ("protobuf_unittest.TestAllTypes", type.name());
+  EXPECT_EQ(0u, resolver.stats().hits);
+  EXPECT_EQ(3u, resolver.stats().misses);
+}
+
+TEST(CachingTypeResolverTest, SharesCachedTypes) {
+  std::unique_ptr<TypeResolver> delegate(NewTypeResolverForDescriptorPool(
+      kUrlPrefix, DescriptorPool::generated_pool()));
+  CachingTypeResolver resolver(delegate.get());
+  CachingTypeResolver other(delegate.get());
+  EXPECT_NE(0u, resolver.ResolutionToken());
+  EXPECT_NE(resolver.ResolutionToken(), other.ResolutionToken());
+  EXPECT_EQ(0u, delegate->ResolutionToken());
+
+  const std::string url = GetTypeUrl<protobuf_unittest::TestAllTypes>();
+  auto first = resolver.FindMessageType(url);
+  auto second = resolver.FindMessageType(url);
+  ASSERT_TRUE(first.ok());
+  ASSERT_TRUE(second.ok());
+  EXPECT_EQ(first->get(), second->get());
+
+  const uint64_t token = resolver.ResolutionToken();
+  resolver.Clear();
+  EXPECT_NE(token, resolver.ResolutionToken());
+  // Types handed out before Clear() stay valid.
+  EXPECT_EQ("protobuf_unittest.TestAllTypes", (*first)->name());
+  auto third = resolver.FindMessageType(url);
+  ASSERT_TRUE(third.ok());
+  EXPECT_NE(first->get(), third->get());
+}
+
+TEST(CachingTypeResolverTest, JsonConversionsReuseResolvedTypes) {
+  std::unique_ptr<TypeResolver> delegate(NewTypeResolverForDescriptorPool(
+      kUrlPrefix, DescriptorPool::generated_pool()));
+  CachingTypeResolver resolver(delegate.get());
+
+  protobuf_unittest::TestAllTypes message;
+  message.mutable_optional_nested_message()->set_bb(1);
+  message.set_optional_nested_enum(protobuf_unittest::TestAllTypes::BAR);
+  const std::string url = GetTypeUrl<protobuf_unittest::TestAllTypes>();
+  std::string json;
+  ASSERT_TRUE(
+      BinaryToJsonString(&resolver, url, message.SerializeAsString(), &json)
+          .ok());
+  const CachingTypeResolver::Stats stats = resolver.stats();
+
+  // The second conversion finds every type it needs in the pool the first one
+  // left behind, without going back to the resolver.
+  std::string binary;
+  ASSERT_TRUE(JsonToBinaryString(&resolver, url, json, &binary).ok());
+  std::string again;
+  ASSERT_TRUE(BinaryToJsonString(&resolver, url, binary, &again).ok());
+  EXPECT_EQ(json, again);
+  again.clear();
+  EXPECT_EQ(stats.hits, resolver.stats().hits);
+  EXPECT_EQ(stats.misses, resolver.stats().misses);
+
+  // After Clear() the types are looked up again.
+  resolver.Clear();
+  ASSERT_TRUE(BinaryToJsonString(&resolver, url, binary, &again).ok());
+  EXPECT_EQ(json, again);
+  EXPECT_LT(stats.misses, resolver.stats().misses);
+}
+
 }  // namespace
 }  // namespace util
 }  // namespace protobuf
@@ -0,0 +1,375 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_field_reader.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+using internal::WireFormat;
+using internal::WireFormatLite;
+
+// The paths are compiled into a trie. A Node stands for a message type and
+// maps field numbers to the Steps that continue into that field.
+struct WireFieldReader::Step {
+  const FieldDescriptor* field;
+  // The selected element of a repeated field, or -1 for all of them.
+  int index;
+  // The paths that end at this step.
+  std::vector<int> leaves;
+  // The rest of the paths that pass through this step, if any.
+  std::unique_ptr<Node> child;
+};
+
+struct WireFieldReader::Node {
+  absl::flat_hash_map<int, std::vector<Step>> steps;
+};
+
+// Scan state for one message instance, shared by all occurrences of a
+// singular message field.
+struct WireFieldReader::State {
+  // Number of elements seen so far, per repeated field number.
+  absl::flat_hash_map<int, int> counts;
+  absl::flat_hash_map<const Step*, std::unique_ptr<State>> children;
+};
+
+namespace {
+
+uint64_t DecodeVarint(absl::string_view raw) {
+  io::CodedInputStream stream(reinterpret_cast<const uint8_t*>(raw.data()),
+                              static_cast<int>(raw.size()));
+  uint64_t value = 0;
+  stream.ReadVarint64(&value);
+  return value;
+}
+
+uint32_t DecodeFixed32(absl::string_view raw) {
+  uint32_t value;
+  io::CodedInputStream::ReadLittleEndian32FromArray(
+      reinterpret_cast<const uint8_t*>(raw.data()), &value);
+  return value;
+}
+
+uint64_t DecodeFixed64(absl::string_view raw) {
+  uint64_t value;
+  io::CodedInputStream::ReadLittleEndian64FromArray(
+      reinterpret_cast<const uint8_t*>(raw.data()), &value);
+  return value;
+}
+
+// Splits the contents of a packed field into its elements.
+bool SplitPacked(WireFormatLite::WireType element_type,
+                 absl::string_view payload,
+                 std::vector<absl::string_view>& elements) {
+  switch (element_type) {
+    case WireFormatLite::WIRETYPE_VARINT: {
+      io::CodedInputStream stream(
+          reinterpret_cast<const uint8_t*>(payload.data()),
+          static_cast<int>(payload.size()));
+      while (stream.CurrentPosition() < static_cast<int>(payload.size())) {
+        const int start = stream.CurrentPosition();
+        uint64_t ignored;
+        if (!stream.ReadVarint64(&ignored)) return false;
+        elements.push_back(
+            payload.substr(start, stream.CurrentPosition() - start));
+      }
+      return true;
+    }
+    case WireFormatLite::WIRETYPE_FIXED32:
+    case WireFormatLite::WIRETYPE_FIXED64: {
+      const size_t width =
+          element_type == WireFormatLite::WIRETYPE_FIXED32 ? 4 : 8;
+      if (payload.size() % width != 0) return false;
+      for (size_t i = 0; i < payload.size(); i += width) {
+        elements.push_back(payload.substr(i, width));
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+int64_t WireFieldReader::Value::GetInt64(int index) const {
+  switch (field_->type()) {
+    case FieldDescriptor::TYPE_INT32:
+    case FieldDescriptor::TYPE_ENUM:
+      return static_cast<int32_t>(DecodeVarint(raw(index)));
+    case FieldDescriptor::TYPE_INT64:
+      return static_cast<int64_t>(DecodeVarint(raw(index)));
+    case FieldDescriptor::TYPE_SINT32:
+      return WireFormatLite::ZigZagDecode32(
+          static_cast<uint32_t>(DecodeVarint(raw(index))));
+    case FieldDescriptor::TYPE_SINT64:
+      return WireFormatLite::ZigZagDecode64(DecodeVarint(raw(index)));
+    case FieldDescriptor::TYPE_SFIXED32:
+      return static_cast<int32_t>(DecodeFixed32(raw(index)));
+    case FieldDescriptor::TYPE_SFIXED64:
+      return static_cast<int64_t>(DecodeFixed64(raw(index)));
+    default:
+      ABSL_LOG(FATAL) << "GetInt64() called on field " << field_->full_name()
+                      << " of type " << field_->type_name() << ".";
+      return 0;
+  }
+}
+
+uint64_t WireFieldReader::Value::GetUInt64(int index) const {
+  switch (field_->type()) {
+    case FieldDescriptor::TYPE_UINT32:
+      return static_cast<uint32_t>(DecodeVarint(raw(index)));
+    case FieldDescriptor::TYPE_UINT64:
+      return DecodeVarint(raw(index));
+    case FieldDescriptor::TYPE_BOOL:
+      return DecodeVarint(raw(index)) != 0;
+    case FieldDescriptor::TYPE_FIXED32:
+      return DecodeFixed32(raw(index));
+    case FieldDescriptor::TYPE_FIXED64:
+      return DecodeFixed64(raw(index));
+    default:
+      ABSL_LOG(FATAL) << "GetUInt64() called on field " << field_->full_name()
+                      << " of type " << field_->type_name() << ".";
+      return 0;
+  }
+}
+
+double WireFieldReader::Value::GetDouble(int index) const {
+  switch (field_->type()) {
+    case FieldDescriptor::TYPE_FLOAT:
+      return WireFormatLite::DecodeFloat(DecodeFixed32(raw(index)));
+    case FieldDescriptor::TYPE_DOUBLE:
+      return WireFormatLite::DecodeDouble(DecodeFixed64(raw(index)));
+    default:
+      ABSL_LOG(FATAL) << "GetDouble() called on field " << field_->full_name()
+                      << " of type " << field_->type_name() << ".";
+      return 0;
+  }
+}
+
+WireFieldReader::WireFieldReader(const Descriptor* descriptor)
+    : descriptor_(descriptor), root_(new Node) {}
+
+WireFieldReader::~WireFieldReader() = default;
+
+absl::StatusOr<int> WireFieldReader::AddPath(absl::string_view path) {
+  std::vector<absl::string_view> components = absl::StrSplit(path, '.');
+  const Descriptor* type = descriptor_;
+  Node* node = root_.get();
+  for (size_t i = 0; i < components.size(); ++i) {
+    absl::string_view name = components[i];
+    const bool last = i + 1 == components.size();
+
+    int index = -1;
+    const size_t bracket = name.find('[');
+    if (bracket != absl::string_view::npos) {
+      absl::string_view digits = name.substr(bracket + 1);
+      if (!absl::ConsumeSuffix(&digits, "]") ||
+          !absl::SimpleAtoi(digits, &index) || index < 0) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Invalid index in path component \"", name, "\"."));
+      }
+      name = name.substr(0, bracket);
+    }
+
+    const FieldDescriptor* field = type->FindFieldByName(std::string(name));
+    if (field == nullptr) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "\"", type->full_name(), "\" has no field named \"", name, "\"."));
+    }
+    if (index >= 0 && !field->is_repeated()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Field \"", field->full_name(), "\" is not repeated."));
+    }
+    if (!last) {
+      if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Field \"", field->full_name(), "\" is not a message."));
+      }
+      if (field->is_repeated() && index < 0) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Repeated field \"", field->full_name(),
+                         "\" needs an index in the middle of a path."));
+      }
+    }
+
+    std::vector<Step>& steps = node->steps[field->number()];
+    Step* step = nullptr;
+    for (Step& existing : steps) {
+      if (existing.index == index) step = &existing;
+    }
+    if (step == nullptr) {
+      steps.push_back(Step{field, index, {}, nullptr});
+      step = &steps.back();
+    }
+
+    if (last) {
+      step->leaves.push_back(static_cast<int>(leaf_fields_.size()));
+      leaf_fields_.push_back(field);
+      return step->leaves.back();
+    }
+    if (step->child == nullptr) step->child.reset(new Node);
+    node = step->child.get();
+    type = field->message_type();
+  }
+  return absl::InvalidArgumentError("Empty path.");
+}
+
+bool WireFieldReader::Read(absl::string_view input,
+                           std::vector<Value>* values) const {
+  values->clear();
+  values->resize(leaf_fields_.size());
+  for (size_t i = 0; i < leaf_fields_.size(); ++i) {
+    (*values)[i].field_ = leaf_fields_[i];
+  }
+  State state;
+  return Scan(*root_, input, 0, state, *values);
+}
+
+bool WireFieldReader::Scan(const Node& node, absl::string_view input,
+                           int depth, State& state,
+                           std::vector<Value>& values) const {
+  if (depth > io::CodedInputStream::GetDefaultRecursionLimit()) return false;
+
+  io::CodedInputStream stream(reinterpret_cast<const uint8_t*>(input.data()),
+                              static_cast<int>(input.size()));
+  std::vector<absl::string_view> elements;
+  while (true) {
+    const uint32_t tag = stream.ReadTag();
+    if (tag == 0) {
+      return stream.CurrentPosition() == static_cast<int>(input.size());
+    }
+    const WireFormatLite::WireType wire_type =
+        WireFormatLite::GetTagWireType(tag);
+    if (wire_type == WireFormatLite::WIRETYPE_END_GROUP) return false;
+
+    const int number = WireFormatLite::GetTagFieldNumber(tag);
+    auto it = node.steps.find(number);
+    if (it == node.steps.end()) {
+      if (!WireFormatLite::SkipField(&stream, tag)) return false;
+      continue;
+    }
+
+    // A value with an unexpected wire type is an unknown field to the parser.
+    const FieldDescriptor* field = it->second.front().field;
+    const WireFormatLite::WireType expected =
+        WireFormat::WireTypeForFieldType(field->type());
+    const bool packed = field->is_packable() &&
+                        wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+    if (wire_type != expected && !packed) {
+      if (!WireFormatLite::SkipField(&stream, tag)) return false;
+      continue;
+    }
+
+    int start = stream.CurrentPosition();
+    int end;
+    switch (wire_type) {
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        uint32_t length;
+        if (!stream.ReadVarint32(&length)) return false;
+        start = stream.CurrentPosition();
+        if (!stream.Skip(static_cast<int>(length))) return false;
+        end = stream.CurrentPosition();
+        break;
+      }
+      case WireFormatLite::WIRETYPE_START_GROUP:
+        if (!WireFormatLite::SkipField(&stream, tag)) return false;
+        end = stream.CurrentPosition() -
+              io::CodedOutputStream::VarintSize32(WireFormatLite::MakeTag(
+                  number, WireFormatLite::WIRETYPE_END_GROUP));
+        break;
+      default:
+        if (!WireFormatLite::SkipField(&stream, tag)) return false;
+        end = stream.CurrentPosition();
+        break;
+    }
+    absl::string_view payload = input.substr(start, end - start);
+
+    elements.clear();
+    if (packed && expected != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!SplitPacked(expected, payload, elements)) return false;
+    } else {
+      elements.push_back(payload);
+    }
+
+    for (absl::string_view element : elements) {
+      const int element_index =
+          field->is_repeated() ? state.counts[number]++ : -1;
+      for (const Step& step : it->second) {
+        if (step.index >= 0 && step.index != element_index) continue;
+        for (int leaf : step.leaves) {
+          std::vector<absl::string_view>& raw = values[leaf].raw_;
+          // Singular scalars take the last value; everything else collects.
+          if (!field->is_repeated() &&
+              field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+            raw.clear();
+          }
+          raw.push_back(element);
+        }
+        if (step.child != nullptr) {
+          std::unique_ptr<State>& child = state.children[&step];
+          if (child == nullptr) child.reset(new State);
+          if (!Scan(*step.child, element, depth + 1, *child, values)) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
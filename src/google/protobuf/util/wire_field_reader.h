@@ -0,0 +1,144 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Defines a reader that extracts individual fields from serialized messages
+// without parsing them.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_WIRE_FIELD_READER_H__
+#define GOOGLE_PROTOBUF_UTIL_WIRE_FIELD_READER_H__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Extracts a set of fields, given as paths like "a.b[3].c", from serialized
+// messages of one type. All paths are looked up in a single pass over the
+// bytes; fields that are not on any path are skipped by their length or wire
+// type without being decoded.
+//
+// Usage:
+//   WireFieldReader reader(Document::descriptor());
+//   int title = reader.AddPath("header.title").value();
+//   int third_tag = reader.AddPath("tags[2]").value();
+//   std::vector<WireFieldReader::Value> values;
+//   if (reader.Read(serialized, &values) && !values[title].empty()) {
+//     absl::string_view t = values[title].GetString();
+//   }
+//
+// Every path component names a field of the message type reached so far.
+// Repeated fields must be indexed with [n] unless they are the last
+// component, in which case either the n-th element or, without an index,
+// every element is returned. The values follow the parser's merge semantics:
+// a singular field set several times yields its last value, and repeated
+// fields inside a singular message that occurs several times are counted
+// across all of its occurrences. Setting another member of a oneof does not
+// clear values already found under an earlier member.
+//
+// Once all paths are added, Read() may be called from several threads at
+// once.
+class PROTOBUF_EXPORT WireFieldReader {
+ public:
+  // The values found for one path. The returned views point into the buffer
+  // that was passed to Read().
+  class PROTOBUF_EXPORT Value {
+   public:
+    // The last field of the path.
+    const FieldDescriptor* field() const { return field_; }
+
+    bool empty() const { return raw_.empty(); }
+    int size() const { return static_cast<int>(raw_.size()); }
+
+    // The encoded value: the varint or fixed-width bytes for numeric fields,
+    // or the contents of a string, bytes or message field. A singular message
+    // field that occurs several times has one entry per occurrence; parsing
+    // them all into the same message gives the merged value.
+    absl::string_view raw(int index = 0) const { return raw_[index]; }
+
+    // Decoded values. GetInt64() accepts every signed integer type and enums,
+    // GetUInt64() every unsigned integer type and bool, GetDouble() float and
+    // double, and GetString() string, bytes and message fields.
+    int64_t GetInt64(int index = 0) const;
+    uint64_t GetUInt64(int index = 0) const;
+    double GetDouble(int index = 0) const;
+    bool GetBool(int index = 0) const { return GetUInt64(index) != 0; }
+    absl::string_view GetString(int index = 0) const { return raw(index); }
+
+   private:
+    friend class WireFieldReader;
+
+    const FieldDescriptor* field_ = nullptr;
+    std::vector<absl::string_view> raw_;
+  };
+
+  explicit WireFieldReader(const Descriptor* descriptor);
+  WireFieldReader(const WireFieldReader&) = delete;
+  WireFieldReader& operator=(const WireFieldReader&) = delete;
+  ~WireFieldReader();
+
+  // Compiles `path` against the message type and returns the index of its
+  // Value in the output of Read().
+  absl::StatusOr<int> AddPath(absl::string_view path);
+
+  // Scans `input`, a serialized message, and fills `values` with one Value
+  // per added path. Returns false if `input` is not valid wire format.
+  bool Read(absl::string_view input, std::vector<Value>* values) const;
+
+ private:
+  struct Node;
+  struct Step;
+  struct State;
+
+  bool Scan(const Node& node, absl::string_view input, int depth,
+            State& state, std::vector<Value>& values) const;
+
+  const Descriptor* descriptor_;
+  std::unique_ptr<Node> root_;
+  std::vector<const FieldDescriptor*> leaf_fields_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_WIRE_FIELD_READER_H__
@@ -0,0 +1,174 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_field_reader.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using protobuf_unittest::NestedTestAllTypes;
+using protobuf_unittest::TestAllTypes;
+using protobuf_unittest::TestPackedTypes;
+
+TEST(WireFieldReaderTest, ReadsScalars) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  WireFieldReader reader(TestAllTypes::descriptor());
+  const int int32 = reader.AddPath("optional_int32").value();
+  const int sint64 = reader.AddPath("optional_sint64").value();
+  const int sfixed32 = reader.AddPath("optional_sfixed32").value();
+  const int fixed64 = reader.AddPath("optional_fixed64").value();
+  const int boolean = reader.AddPath("optional_bool").value();
+  const int float_value = reader.AddPath("optional_float").value();
+  const int double_value = reader.AddPath("optional_double").value();
+  const int string = reader.AddPath("optional_string").value();
+  const int nested_enum = reader.AddPath("optional_nested_enum").value();
+  const int group = reader.AddPath("optionalgroup.a").value();
+  const int bb = reader.AddPath("optional_nested_message.bb").value();
+
+  const std::string input = message.SerializeAsString();
+  std::vector<WireFieldReader::Value> values;
+  ASSERT_TRUE(reader.Read(input, &values));
+  ASSERT_EQ(11, values.size());
+  EXPECT_EQ(message.optional_int32(), values[int32].GetInt64());
+  EXPECT_EQ(message.optional_sint64(), values[sint64].GetInt64());
+  EXPECT_EQ(message.optional_sfixed32(), values[sfixed32].GetInt64());
+  EXPECT_EQ(message.optional_fixed64(), values[fixed64].GetUInt64());
+  EXPECT_EQ(message.optional_bool(), values[boolean].GetBool());
+  EXPECT_EQ(message.optional_float(), values[float_value].GetDouble());
+  EXPECT_EQ(message.optional_double(), values[double_value].GetDouble());
+  EXPECT_EQ(message.optional_string(), values[string].GetString());
+  EXPECT_EQ(message.optional_nested_enum(), values[nested_enum].GetInt64());
+  EXPECT_EQ(message.optionalgroup().a(), values[group].GetInt64());
+  EXPECT_EQ(message.optional_nested_message().bb(), values[bb].GetInt64());
+}
+
+TEST(WireFieldReaderTest, ReadsRepeatedElements) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  message.add_repeated_int32(-5);
+  WireFieldReader reader(TestAllTypes::descriptor());
+  const int all = reader.AddPath("repeated_int32").value();
+  const int last = reader.AddPath("repeated_int32[2]").value();
+  const int missing = reader.AddPath("repeated_int32[3]").value();
+  const int nested = reader.AddPath("repeated_nested_message[1].bb").value();
+
+  const std::string input = message.SerializeAsString();
+  std::vector<WireFieldReader::Value> values;
+  ASSERT_TRUE(reader.Read(input, &values));
+  ASSERT_EQ(3, values[all].size());
+  EXPECT_EQ(message.repeated_int32(0), values[all].GetInt64(0));
+  EXPECT_EQ(message.repeated_int32(1), values[all].GetInt64(1));
+  EXPECT_EQ(-5, values[last].GetInt64());
+  EXPECT_TRUE(values[missing].empty());
+  EXPECT_EQ(message.repeated_nested_message(1).bb(), values[nested].GetInt64());
+}
+
+TEST(WireFieldReaderTest, ReadsPackedElements) {
+  TestPackedTypes message;
+  message.add_packed_int32(1);
+  message.add_packed_int32(-2);
+  message.add_packed_int32(3);
+  message.add_packed_double(1.5);
+  message.add_packed_double(2.5);
+  WireFieldReader reader(TestPackedTypes::descriptor());
+  const int second_int = reader.AddPath("packed_int32[1]").value();
+  const int doubles = reader.AddPath("packed_double").value();
+
+  const std::string input = message.SerializeAsString();
+  std::vector<WireFieldReader::Value> values;
+  ASSERT_TRUE(reader.Read(input, &values));
+  EXPECT_EQ(-2, values[second_int].GetInt64());
+  ASSERT_EQ(2, values[doubles].size());
+  EXPECT_EQ(2.5, values[doubles].GetDouble(1));
+}
+
+TEST(WireFieldReaderTest, FollowsMergeSemantics) {
+  NestedTestAllTypes first, second;
+  first.mutable_child()->mutable_payload()->set_optional_int32(1);
+  first.mutable_child()->mutable_payload()->add_repeated_string("a");
+  second.mutable_child()->mutable_payload()->set_optional_int32(2);
+  second.mutable_child()->mutable_payload()->add_repeated_string("b");
+  second.mutable_child()->mutable_payload()->add_repeated_string("c");
+  const std::string input =
+      first.SerializeAsString() + second.SerializeAsString();
+
+  WireFieldReader reader(NestedTestAllTypes::descriptor());
+  const int int32 = reader.AddPath("child.payload.optional_int32").value();
+  const int string = reader.AddPath("child.payload.repeated_string[1]").value();
+  const int payload = reader.AddPath("child.payload").value();
+
+  std::vector<WireFieldReader::Value> values;
+  ASSERT_TRUE(reader.Read(input, &values));
+  EXPECT_EQ(2, values[int32].GetInt64());
+  EXPECT_EQ("b", values[string].GetString());
+
+  ASSERT_EQ(2, values[payload].size());
+  TestAllTypes merged;
+  ASSERT_TRUE(merged.ParseFromString(values[payload].raw(0)));
+  ASSERT_TRUE(merged.MergeFromString(values[payload].raw(1)));
+  EXPECT_EQ(2, merged.optional_int32());
+  EXPECT_EQ(3, merged.repeated_string_size());
+}
+
+TEST(WireFieldReaderTest, RejectsInvalidPaths) {
+  WireFieldReader reader(TestAllTypes::descriptor());
+  EXPECT_FALSE(reader.AddPath("no_such_field").ok());
+  EXPECT_FALSE(reader.AddPath("optional_int32.foo").ok());
+  EXPECT_FALSE(reader.AddPath("optional_int32[0]").ok());
+  EXPECT_FALSE(reader.AddPath("repeated_int32[-1]").ok());
+  EXPECT_FALSE(reader.AddPath("repeated_int32[x]").ok());
+  EXPECT_FALSE(reader.AddPath("repeated_nested_message.bb").ok());
+  EXPECT_FALSE(reader.AddPath("").ok());
+}
+
+TEST(WireFieldReaderTest, RejectsInvalidInput) {
+  WireFieldReader reader(TestAllTypes::descriptor());
+  ASSERT_TRUE(reader.AddPath("optional_int32").ok());
+  std::vector<WireFieldReader::Value> values;
+  // A length-delimited field that runs past the end of the input.
+  EXPECT_FALSE(reader.Read("\x72\x05" "ab", &values));
+  // A truncated varint.
+  EXPECT_FALSE(reader.Read("\x08\x80", &values));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,295 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_merge_util.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using internal::WireFormat;
+using internal::WireFormatLite;
+
+// One encoded occurrence of a field in one of the inputs.
+struct Occurrence {
+  // The tag and the value.
+  absl::string_view encoded;
+  // The contents of a length-delimited value or of a group.
+  absl::string_view payload;
+  // Position across all inputs, so that oneof members can be ordered.
+  int sequence;
+};
+
+// All occurrences of one known field, in input order.
+struct FieldOccurrences {
+  int number;
+  const FieldDescriptor* field;
+  std::vector<Occurrence> occurrences;
+};
+
+const FieldDescriptor* FindField(const Descriptor* descriptor, int number) {
+  const FieldDescriptor* field = descriptor->FindFieldByNumber(number);
+  if (field == nullptr && descriptor->extension_range_count() > 0) {
+    field = descriptor->file()->pool()->FindExtensionByNumber(descriptor,
+                                                              number);
+  }
+  return field;
+}
+
+bool HasExpectedWireType(const FieldDescriptor* field,
+                         WireFormatLite::WireType wire_type) {
+  if (wire_type == WireFormat::WireTypeForFieldType(field->type())) {
+    return true;
+  }
+  return field->is_packable() &&
+         wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+}
+
+void AppendVarint(uint32_t value, std::string* output) {
+  uint8_t buffer[5];  // Enough for any 32-bit varint.
+  uint8_t* end = io::CodedOutputStream::WriteVarint32ToArray(value, buffer);
+  output->append(reinterpret_cast<const char*>(buffer), end - buffer);
+}
+
+// Splits `input` into fields, appending known fields to `fields` and the
+// rest to `unknown`. Occurrences whose wire type does not match the field's
+// declared type end up in the unknown field set when parsed, so they count
+// as unknown too.
+bool ScanFields(const Descriptor* descriptor, absl::string_view input,
+                std::vector<FieldOccurrences>& fields,
+                absl::flat_hash_map<int, size_t>& index,
+                std::vector<absl::string_view>& unknown, int& sequence) {
+  io::CodedInputStream stream(reinterpret_cast<const uint8_t*>(input.data()),
+                              static_cast<int>(input.size()));
+  while (true) {
+    const int start = stream.CurrentPosition();
+    const uint32_t tag = stream.ReadTag();
+    if (tag == 0) return start == static_cast<int>(input.size());
+
+    const int number = WireFormatLite::GetTagFieldNumber(tag);
+    const WireFormatLite::WireType wire_type =
+        WireFormatLite::GetTagWireType(tag);
+    int payload_start = stream.CurrentPosition();
+    int payload_end;
+    switch (wire_type) {
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        uint32_t length;
+        if (!stream.ReadVarint32(&length)) return false;
+        payload_start = stream.CurrentPosition();
+        if (!stream.Skip(static_cast<int>(length))) return false;
+        payload_end = stream.CurrentPosition();
+        break;
+      }
+      case WireFormatLite::WIRETYPE_START_GROUP:
+        if (!WireFormatLite::SkipField(&stream, tag)) return false;
+        payload_end =
+            stream.CurrentPosition() -
+            io::CodedOutputStream::VarintSize32(WireFormatLite::MakeTag(
+                number, WireFormatLite::WIRETYPE_END_GROUP));
+        break;
+      case WireFormatLite::WIRETYPE_END_GROUP:
+        // Only valid as the end of a group, which SkipField() consumes.
+        return false;
+      default:
+        if (!WireFormatLite::SkipField(&stream, tag)) return false;
+        payload_end = payload_start;
+        break;
+    }
+
+    absl::string_view encoded =
+        input.substr(start, stream.CurrentPosition() - start);
+    const FieldDescriptor* field = FindField(descriptor, number);
+    if (field == nullptr || !HasExpectedWireType(field, wire_type)) {
+      unknown.push_back(encoded);
+      continue;
+    }
+    auto it = index.try_emplace(number, fields.size()).first;
+    if (it->second == fields.size()) {
+      fields.push_back(FieldOccurrences{number, field, {}});
+    }
+    fields[it->second].occurrences.push_back(Occurrence{
+        encoded, input.substr(payload_start, payload_end - payload_start),
+        sequence++});
+  }
+}
+
+// Drops every oneof member except the one set last, and of that member only
+// keeps the occurrences after the last time another member was set.
+void ApplyOneofSemantics(const Descriptor* descriptor,
+                         std::vector<FieldOccurrences>& fields) {
+  for (int i = 0; i < descriptor->oneof_decl_count(); ++i) {
+    const OneofDescriptor* oneof = descriptor->oneof_decl(i);
+    FieldOccurrences* winner = nullptr;
+    for (FieldOccurrences& entry : fields) {
+      if (entry.field->containing_oneof() != oneof) {
+        continue;
+      }
+      if (winner == nullptr || entry.occurrences.back().sequence >
+                                   winner->occurrences.back().sequence) {
+        winner = &entry;
+      }
+    }
+    if (winner == nullptr) continue;
+
+    int last_other = -1;
+    for (FieldOccurrences& entry : fields) {
+      if (&entry == winner || entry.field->containing_oneof() != oneof) {
+        continue;
+      }
+      last_other = std::max(last_other, entry.occurrences.back().sequence);
+      entry.occurrences.clear();
+    }
+    std::vector<Occurrence>& kept = winner->occurrences;
+    kept.erase(std::remove_if(kept.begin(), kept.end(),
+                              [&](const Occurrence& occurrence) {
+                                return occurrence.sequence < last_other;
+                              }),
+               kept.end());
+  }
+}
+
+bool MergeFields(const Descriptor* descriptor,
+                 const std::vector<absl::string_view>& inputs, int depth,
+                 std::string* output) {
+  if (depth > io::CodedInputStream::GetDefaultRecursionLimit()) return false;
+
+  std::vector<FieldOccurrences> fields;
+  absl::flat_hash_map<int, size_t> index;
+  std::vector<absl::string_view> unknown;
+  int sequence = 0;
+  for (absl::string_view input : inputs) {
+    if (!ScanFields(descriptor, input, fields, index, unknown, sequence)) {
+      return false;
+    }
+  }
+
+  // MessageSet items are all groups with the same number; concatenating them
+  // already has the right semantics.
+  if (descriptor->options().message_set_wire_format()) {
+    for (absl::string_view input : inputs) {
+      output->append(input.data(), input.size());
+    }
+    return true;
+  }
+
+  ApplyOneofSemantics(descriptor, fields);
+
+  for (const FieldOccurrences& entry : fields) {
+    const std::vector<Occurrence>& occurrences = entry.occurrences;
+    if (occurrences.empty()) continue;
+    const FieldDescriptor* field = entry.field;
+
+    // Repeated fields keep every occurrence. So do closed enums, since an
+    // unrecognized value goes to the unknown fields instead of replacing the
+    // earlier one.
+    if (field->is_repeated() ||
+        (field->type() == FieldDescriptor::TYPE_ENUM &&
+         field->legacy_enum_field_treated_as_closed())) {
+      for (const Occurrence& occurrence : occurrences) {
+        output->append(occurrence.encoded.data(), occurrence.encoded.size());
+      }
+      continue;
+    }
+
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE ||
+        occurrences.size() == 1) {
+      const Occurrence& last = occurrences.back();
+      output->append(last.encoded.data(), last.encoded.size());
+      continue;
+    }
+
+    std::vector<absl::string_view> payloads;
+    payloads.reserve(occurrences.size());
+    for (const Occurrence& occurrence : occurrences) {
+      payloads.push_back(occurrence.payload);
+    }
+    std::string merged;
+    if (!MergeFields(field->message_type(), payloads, depth + 1, &merged)) {
+      return false;
+    }
+    if (field->type() == FieldDescriptor::TYPE_GROUP) {
+      AppendVarint(
+          WireFormatLite::MakeTag(entry.number,
+                                  WireFormatLite::WIRETYPE_START_GROUP),
+          output);
+      output->append(merged);
+      AppendVarint(
+          WireFormatLite::MakeTag(entry.number,
+                                  WireFormatLite::WIRETYPE_END_GROUP),
+          output);
+    } else {
+      AppendVarint(
+          WireFormatLite::MakeTag(entry.number,
+                                  WireFormatLite::WIRETYPE_LENGTH_DELIMITED),
+          output);
+      AppendVarint(static_cast<uint32_t>(merged.size()), output);
+      output->append(merged);
+    }
+  }
+
+  // Like the parser, keep unknown fields in their original order, after the
+  // known ones.
+  for (absl::string_view encoded : unknown) {
+    output->append(encoded.data(), encoded.size());
+  }
+  return true;
+}
+
+}  // namespace
+
+bool MergeSerializedMessages(const Descriptor* descriptor,
+                             absl::string_view base, absl::string_view patch,
+                             std::string* output) {
+  output->clear();
+  return MergeFields(descriptor, {base, patch}, 0, output);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,78 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Defines utilities for merging serialized messages without parsing them.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_WIRE_MERGE_UTIL_H__
+#define GOOGLE_PROTOBUF_UTIL_WIRE_MERGE_UTIL_H__
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Merges the serialized message `patch` into the serialized message `base`,
+// both of type `descriptor`, and stores the result in `*output`. Parsing the
+// result gives the same message as parsing `base` and calling MergeFrom() with
+// the parsed `patch`:
+//   * singular scalar, string and bytes fields take the last value seen;
+//   * repeated fields (including maps) are concatenated;
+//   * singular message fields present in both inputs are merged recursively;
+//   * setting a different member of a oneof drops the earlier member;
+//   * unknown fields are kept in order.
+//
+// Only the fields are decoded; submessages are parsed only when they occur
+// more than once and so have to be merged, and everything else is copied
+// through as is. The output is usually smaller than `base` + `patch` (which
+// parses to the same message) because overwritten values are dropped.
+//
+// Returns false if the top level of either input, or a submessage that has to
+// be merged, is not valid wire format. Submessages that are copied through
+// are not checked, so a malformed one that occurs only once is carried into
+// `*output` unchanged and is only detected when the result is parsed.
+PROTOBUF_EXPORT bool MergeSerializedMessages(const Descriptor* descriptor,
+                                             absl::string_view base,
+                                             absl::string_view patch,
+                                             std::string* output);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_WIRE_MERGE_UTIL_H__
@@ -0,0 +1,177 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_merge_util.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/util/message_differencer.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using protobuf_unittest::NestedTestAllTypes;
+using protobuf_unittest::TestAllExtensions;
+using protobuf_unittest::TestAllTypes;
+using protobuf_unittest::TestEmptyMessage;
+
+// Checks that merging the serialized forms gives the same message as
+// MergeFrom(), and returns the merged bytes.
+template <typename T>
+std::string ExpectMergeMatchesMergeFrom(const T& base, const T& patch) {
+  std::string merged;
+  EXPECT_TRUE(MergeSerializedMessages(T::descriptor(),
+                                      base.SerializeAsString(),
+                                      patch.SerializeAsString(), &merged));
+  T expected = base;
+  expected.MergeFrom(patch);
+  T actual;
+  EXPECT_TRUE(actual.ParseFromString(merged));
+  EXPECT_TRUE(MessageDifferencer::Equals(expected, actual))
+      << "expected: " << expected.DebugString()
+      << "actual: " << actual.DebugString();
+  return merged;
+}
+
+TEST(WireMergeUtilTest, MergesAllFieldTypes) {
+  TestAllTypes base, patch;
+  TestUtil::SetAllFields(&base);
+  TestUtil::SetAllFields(&patch);
+  TestUtil::ModifyRepeatedFields(&patch);
+  patch.set_optional_int32(-7);
+  patch.set_optional_string("patched");
+  patch.mutable_optional_nested_message()->set_bb(42);
+  patch.mutable_optionalgroup()->set_a(43);
+  ExpectMergeMatchesMergeFrom(base, patch);
+  ExpectMergeMatchesMergeFrom(patch, base);
+  ExpectMergeMatchesMergeFrom(base, TestAllTypes());
+  ExpectMergeMatchesMergeFrom(TestAllTypes(), patch);
+}
+
+TEST(WireMergeUtilTest, MergesSubmessagesRecursively) {
+  NestedTestAllTypes base, patch;
+  base.mutable_child()->mutable_payload()->set_optional_int32(1);
+  base.mutable_child()->mutable_payload()->add_repeated_int32(1);
+  base.mutable_child()->mutable_child()->mutable_payload()->set_optional_string(
+      "base");
+  base.add_repeated_child()->mutable_payload()->set_optional_int64(1);
+  patch.mutable_child()->mutable_payload()->set_optional_int64(2);
+  patch.mutable_child()->mutable_payload()->add_repeated_int32(2);
+  patch.mutable_child()->mutable_child()->mutable_payload()->set_optional_bytes(
+      "patch");
+  patch.add_repeated_child()->mutable_payload()->set_optional_int64(2);
+  ExpectMergeMatchesMergeFrom(base, patch);
+}
+
+TEST(WireMergeUtilTest, OneofLastMemberWins) {
+  TestAllTypes base, patch;
+  base.mutable_oneof_nested_message()->set_bb(1);
+  patch.set_oneof_string("patched");
+  ExpectMergeMatchesMergeFrom(base, patch);
+  ExpectMergeMatchesMergeFrom(patch, base);
+
+  TestAllTypes same_member;
+  same_member.mutable_oneof_nested_message();
+  ExpectMergeMatchesMergeFrom(base, same_member);
+}
+
+TEST(WireMergeUtilTest, MergesExtensions) {
+  TestAllExtensions base, patch;
+  TestUtil::SetAllExtensions(&base);
+  TestUtil::SetAllExtensions(&patch);
+  TestUtil::ModifyRepeatedExtensions(&patch);
+  patch.MutableExtension(protobuf_unittest::optional_nested_message_extension)
+      ->set_bb(42);
+  ExpectMergeMatchesMergeFrom(base, patch);
+}
+
+TEST(WireMergeUtilTest, KeepsUnknownFields) {
+  TestAllTypes all;
+  TestUtil::SetAllFields(&all);
+  TestEmptyMessage base, patch;
+  ASSERT_TRUE(base.ParseFromString(all.SerializeAsString()));
+  ASSERT_TRUE(patch.ParseFromString(all.SerializeAsString()));
+  std::string merged;
+  ASSERT_TRUE(MergeSerializedMessages(TestEmptyMessage::descriptor(),
+                                      base.SerializeAsString(),
+                                      patch.SerializeAsString(), &merged));
+  EXPECT_EQ(base.SerializeAsString() + patch.SerializeAsString(), merged);
+}
+
+TEST(WireMergeUtilTest, DropsOverwrittenValues) {
+  TestAllTypes base, patch;
+  TestUtil::SetAllFields(&base);
+  patch.set_optional_int32(1);
+  patch.set_optional_string("x");
+  std::string merged = ExpectMergeMatchesMergeFrom(base, patch);
+  for (int i = 0; i < 10; ++i) {
+    std::string next;
+    ASSERT_TRUE(MergeSerializedMessages(TestAllTypes::descriptor(), merged,
+                                        patch.SerializeAsString(), &next));
+    EXPECT_EQ(merged.size(), next.size());
+    merged = next;
+  }
+}
+
+TEST(WireMergeUtilTest, RejectsInvalidInput) {
+  std::string merged;
+  // A length-delimited field that runs past the end of the input.
+  EXPECT_FALSE(MergeSerializedMessages(TestAllTypes::descriptor(),
+                                       "\x72\x05" "ab", "", &merged));
+  // An end-group tag without a start.
+  EXPECT_FALSE(MergeSerializedMessages(TestAllTypes::descriptor(), "",
+                                       "\x0c", &merged));
+  // Invalid contents of a submessage that has to be merged.
+  TestAllTypes valid;
+  valid.mutable_optional_nested_message()->set_bb(1);
+  EXPECT_FALSE(MergeSerializedMessages(TestAllTypes::descriptor(),
+                                       valid.SerializeAsString(),
+                                       "\x92\x01\x02\x08\x80", &merged));
+}
+
+TEST(WireMergeUtilTest, CopiesUnmergedSubmessagesUnchecked) {
+  // A malformed submessage that occurs only once is copied as is.
+  std::string merged;
+  EXPECT_TRUE(MergeSerializedMessages(TestAllTypes::descriptor(), "",
+                                      "\x92\x01\x02\x08\x80", &merged));
+  EXPECT_EQ(merged, "\x92\x01\x02\x08\x80");
+  TestAllTypes parsed;
+  EXPECT_FALSE(parsed.ParseFromString(merged));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google